@@ -2,6 +2,7 @@
 
 #include <cassert>
 #include <fstream>
+#include <memory_resource>
 #include <stack>
 #include <string>
 #include <unordered_map>
@@ -17,34 +18,41 @@
 namespace fl {
 
 // Classical Finite State Transducer (FST) class template
+// all members allocate from the memory resource the FST is constructed with, the stages of realtimeFST build their
+// result with the resource of their input
 template <class Letter>
 class FST {
    public:
-	using State	   = unsigned int;
-	using StringID = unsigned int;
-	using Map	   = unordered_multimap<State, std::tuple<StringID, StringID, State>, fl::hash<State>>;
-	unsigned int						  N;
-	unordered_set<State, fl::hash<State>> qFirsts;
-	unordered_set<State, fl::hash<State>> qFinals;
+	using State			 = unsigned int;
+	using StringID		 = unsigned int;
+	using Map			 = pmr::unordered_multimap<State, std::tuple<StringID, StringID, State>, fl::hash<State>>;
+	using allocator_type = std::pmr::polymorphic_allocator<>;
+	unsigned int								N;
+	pmr::unordered_set<State, fl::hash<State>> qFirsts;
+	pmr::unordered_set<State, fl::hash<State>> qFinals;
 
-	std::vector<std::vector<Letter>> words;		// words on the tapes
-	Map								 transitions;
+	std::pmr::vector<std::pmr::vector<Letter>> words;	  // words on the tapes
+	Map										   transitions;
 
-	constexpr FST() : N(0) {}
+	FST() : FST(allocator_type()) {}
+	explicit FST(const allocator_type &alloc)
+		: N(0), qFirsts(alloc), qFinals(alloc), words(alloc), transitions(alloc) {}
+
+	allocator_type get_allocator() const { return words.get_allocator(); }
 
 	void addTransition(State from, std::vector<Letter> &&w1, std::vector<Letter> &&w2, State to) {
 		StringID id1;
 		if (w1.empty()) id1 = 0;
 		else {
 			id1 = words.size();
-			words.emplace_back(std::move(w1));
+			words.emplace_back(w1.begin(), w1.end());
 		}
 		StringID id2;
 		if (w2.empty()) id2 = 0;
-		else if (words.back() == w2) id2 = id1;
+		else if (std::ranges::equal(words.back(), w2)) id2 = id1;
 		else {
 			id2 = words.size();
-			words.emplace_back(std::move(w2));
+			words.emplace_back(w2.begin(), w2.end());
 		}
 		transitions.insert({from, {id1, id2, to}});
 	}
@@ -480,8 +488,9 @@ inline void saveFSA(const FST<Letter> &fsa, const std::string &filename) {
 	out.close();
 }
 
+/// removes the states that are not both accessible and co-accessible, the result allocates from alloc
 template <class Letter>
-auto trimFSA(FST<Letter> &&fsa) {
+auto trimFSA(FST<Letter> &&fsa, const typename FST<Letter>::allocator_type &alloc) {
 	if (fsa.qFinals.empty()) {
 		fsa.N		= 0;
 		fsa.qFirsts = {0};
@@ -492,19 +501,19 @@ auto trimFSA(FST<Letter> &&fsa) {
 	}
 	using State	   = FST<Letter>::State;
 	using StringID = FST<Letter>::StringID;
-	std::vector<bool> visited_back(fsa.N, false);
-	std::vector<bool> visited_forw(fsa.N, false);
+	std::pmr::vector<bool> visited_back(fsa.N, false, alloc);
+	std::pmr::vector<bool> visited_forw(fsa.N, false, alloc);
 
 	{
-		auto						   &forwardTransitions = fsa.transitions;
-		std::vector<std::vector<State>> backwardTransitions;
+		auto									 &forwardTransitions = fsa.transitions;
+		std::pmr::vector<std::pmr::vector<State>> backwardTransitions(alloc);
 		backwardTransitions.resize(fsa.N);
 		for (const auto &[from, value] : forwardTransitions) {
 			const auto &[id1, id2, to] = value;
 			backwardTransitions[to].push_back(from);
 		}
 
-		std::vector<State> stack;
+		std::pmr::vector<State> stack(alloc);
 		for (const auto &final : fsa.qFinals) {
 			visited_back[final] = true;
 			stack.push_back(final);
@@ -537,12 +546,12 @@ auto trimFSA(FST<Letter> &&fsa) {
 			}
 		}
 	}
-	int				   cnt = 0;
-	std::vector<State> new_map(fsa.N, -1);
+	int						cnt = 0;
+	std::pmr::vector<State> new_map(fsa.N, -1, alloc);
 	for (unsigned int i = 0; i < fsa.N; ++i) {
 		if (visited_back[i] && visited_forw[i]) { new_map[i] = cnt++; }
 	}
-	FST<Letter> new_fsa;
+	FST<Letter> new_fsa(alloc);
 	new_fsa.N = cnt;
 	new_fsa.qFirsts.reserve(fsa.qFirsts.size());
 	for (const auto &q : fsa.qFirsts) {
@@ -554,7 +563,7 @@ auto trimFSA(FST<Letter> &&fsa) {
 		if (new_map[q] != -1u) { new_fsa.qFinals.insert(new_map[q]); }
 	}
 
-	std::vector<bool> words_used(fsa.words.size(), false);
+	std::pmr::vector<bool> words_used(fsa.words.size(), false, alloc);
 	words_used[0] = true;	  // always keep the empty word
 	for (const auto &[from, value] : fsa.transitions) {
 		const auto &[id1, id2, to] = value;
@@ -564,8 +573,8 @@ auto trimFSA(FST<Letter> &&fsa) {
 		}
 	}
 
-	int					  word_cnt = 0;
-	std::vector<StringID> words_index_map(fsa.words.size(), -1);
+	int						   word_cnt = 0;
+	std::pmr::vector<StringID> words_index_map(fsa.words.size(), -1, alloc);
 	for (size_t i = 0; i < fsa.words.size(); ++i) {
 		if (words_used[i]) {
 			new_fsa.words.push_back(std::move(fsa.words[i]));
@@ -587,13 +596,20 @@ auto trimFSA(FST<Letter> &&fsa) {
 	return std::move(new_fsa);
 }
 
+template <class Letter>
+auto trimFSA(FST<Letter> &&fsa) {
+	const auto alloc = fsa.get_allocator();
+	return trimFSA(std::move(fsa), alloc);
+}
+
 template <class Letter>
 auto removeEpsilonFST(FST<Letter> &&fsa) {
 	using State = typename FST<Letter>::State;
 
-	std::stack<State>				stack;
-	std::vector<bool>				visited(fsa.N, false);
-	std::vector<std::vector<State>> closure(fsa.N);
+	const auto								  alloc = fsa.get_allocator();
+	std::stack<State, std::pmr::vector<State>> stack(alloc);
+	std::pmr::vector<bool>					  visited(fsa.N, false, alloc);
+	std::pmr::vector<std::pmr::vector<State>> closure(fsa.N, alloc);
 
 	for (State i = 0; i < fsa.N; ++i) {
 		stack.push(i);
@@ -622,7 +638,7 @@ auto removeEpsilonFST(FST<Letter> &&fsa) {
 		return id1 == 0 && id2 == 0;	 // remove epsilon transitions
 	});
 
-	typename FST<Letter>::Map new_transitions;
+	typename FST<Letter>::Map new_transitions(alloc);
 	new_transitions.insert(fsa.transitions.begin(), fsa.transitions.end());
 	for (const auto &[from, value] : fsa.transitions) {
 		const auto &[id1, id2, to] = value;
@@ -632,7 +648,7 @@ auto removeEpsilonFST(FST<Letter> &&fsa) {
 		}
 	}
 
-	unordered_set<State> new_qFirsts;
+	pmr::unordered_set<State> new_qFirsts(alloc);
 	for (const State &i : fsa.qFirsts) {
 		new_qFirsts.insert(i);
 		for (const State &j : closure[i]) {
@@ -24,14 +24,16 @@ class OutputFSA {
 		auto fst = (FST<Letter>)makeFSA_BerriSethi<Letter>(*ast);
 		fst		 = trimFSA<Letter>(std::move(fst));
 
-		auto realtime = realtimeFST<Letter>(std::move(fst));
-		*this		  = OutputFSA<Letter>(pseudoDeterminizeFST<Letter>(std::move(realtime)), fixedOutput);
+		// the intermediate automata live in one arena, released after the OutputFSA has copied the result
+		std::pmr::monotonic_buffer_resource arena;
+		auto								realtime = realtimeFST<Letter>(std::move(fst), &arena);
+		*this = OutputFSA<Letter>(pseudoDeterminizeFST<Letter>(std::move(realtime)), fixedOutput);
 	}
 
 	OutputFSA(TFSA<Letter> &&tfsa, Letter fixedOutput) {
-		this->N		  = tfsa.N;
-		this->qFinals = std::move(tfsa.qFinals);
-		this->qFirsts = std::move(tfsa.qFirsts);
+		this->N = tfsa.N;
+		this->qFinals.insert(tfsa.qFinals.begin(), tfsa.qFinals.end());
+		this->qFirsts.insert(tfsa.qFirsts.begin(), tfsa.qFirsts.end());
 		for (const auto &[from, rhs] : tfsa.transitions) {
 			const auto &[letter, outputID, to] = rhs;
 			if (!tfsa.words.getWord(outputID).empty())
@@ -45,8 +47,8 @@ class OutputFSA {
 	}
 
 	OutputFSA(SSFT<Letter> &&ssft, Letter fixedOutput) {
-		this->N		  = ssft.N;
-		this->qFinals = std::move(ssft.qFinals);
+		this->N = ssft.N;
+		this->qFinals.insert(ssft.qFinals.begin(), ssft.qFinals.end());
 		this->qFirsts = {0};
 		for (const auto &[lhs, rhs] : ssft.transitions) {
 			const auto &[from, letter] = lhs;
@@ -15,21 +15,44 @@ namespace fl {
 template <class Letter>
 class SSFT {
    public:
-	using State	   = unsigned int;
-	using StringID = WordSet<Letter>::WordID;
-	using Map	   = fl::unordered_map<std::tuple<State, Letter>, std::pair<StringID, State>>;
+	using State			 = unsigned int;
+	using StringID		 = WordSet<Letter>::WordID;
+	using Map			 = pmr::unordered_map<std::tuple<State, Letter>, std::pair<StringID, State>>;
+	using allocator_type = std::pmr::polymorphic_allocator<>;
 
 	WordSet<Letter>						words;
 	Map									transitions;
-	fl::unordered_set<State>			qFinals;
+	pmr::unordered_set<State>			qFinals;
 	unsigned int						N = 0;
-	fl::unordered_map<State, StringID> output;
+	pmr::unordered_map<State, StringID> output;
 
-	SSFT() = default;
+	SSFT() : SSFT(allocator_type()) {}
+	explicit SSFT(const allocator_type &alloc) : words(alloc), transitions(alloc), qFinals(alloc), output(alloc) {}
+
+	allocator_type get_allocator() const { return words.get_allocator(); }
+
+   private:
+	static constexpr std::size_t COMPACT_THRESHOLD = 1 << 16;	  // dead letters in words before compacting
+
+	/// compacts the word pool and renumbers the outputs that refer to it
+	void compactWords() {
+		const auto remap = words.compact();
+		for (auto &[_, rhs] : transitions) {
+			auto &[outputID, to] = rhs;
+			outputID			 = remap[outputID];
+		}
+		for (auto &[_, outputID] : output) {
+			outputID = remap[outputID];
+		}
+	}
+
+   public:
 
 	// accepts a trimmed TFSA and builds a subsequential finite-state transducer
 	// tests for bounded variation
-	SSFT(TFSA<Letter> &&fsa, bool resolveNonFunctionality = false) {
+	// the SSFT allocates from alloc, the work memory of the construction comes from the resource of the TFSA
+	SSFT(TFSA<Letter> &&fsa, bool resolveNonFunctionality = false, const allocator_type &alloc = allocator_type())
+		: SSFT(alloc) {
 		unsigned int C = 0;
 		for (auto w : fsa.words) {
 			if (w.size() > C) C = w.size();
@@ -37,7 +60,7 @@ class SSFT {
 		auto MAX_DELAY = C * fsa.N * fsa.N;		// C * |Q|^2
 		auto curr_max  = 0u;
 
-		UniqueWordSet<Letter> stateDelays;
+		UniqueWordSet<Letter> stateDelays(fsa.get_allocator());
 		using DelayID = UniqueWordSet<Letter>::WordID;
 
 		// We use vector because noone cares about individual states and delays
@@ -77,8 +100,8 @@ class SSFT {
 
 			static WordSet<Letter>		 temporaryWords;	 // used for the new state delays
 			static std::vector<BigState> nextStates;
-			static std::vector<std::reference_wrapper<typename Map::value_type>>
-				  currentTransitions;	  // transitions for the current state
+			// letters of the transitions from the current state, the map moves its elements when it grows
+			static std::vector<Letter> currentLetters;
 			State nextState		= 0;
 			auto  localNewState = [&nextState]() {
 				 auto &ref = nextStates.emplace_back();
@@ -99,8 +122,8 @@ class SSFT {
 						auto new_id		  = words.addWord(wordToDelay);
 						auto temp_id	  = temporaryWords.addWord(wordToDelay);
 						auto [to, to_ind] = localNewState();
-						auto [t_it, b]	  = transitions.insert({{current, s}, {new_id, to_ind}});
-						currentTransitions.emplace_back(std::ref(*t_it));
+						transitions.insert({{current, s}, {new_id, to_ind}});
+						currentLetters.push_back(s);
 						to.get().emplace_back(next, temp_id);
 					} else {
 						auto &[_, rhs]		= *it;
@@ -117,9 +140,8 @@ class SSFT {
 				}
 			}
 
-			for (const auto &ref : currentTransitions) {
-				auto &[_, rhs]		 = ref.get();
-				auto &[outputID, to] = rhs;
+			for (const auto &s : currentLetters) {
+				auto &[outputID, to] = transitions.find({current, s})->second;
 				auto &nextBig		 = nextStates[to];
 
 				for (auto &[q, delay_id] : nextBig) {
@@ -179,9 +201,13 @@ class SSFT {
 								if (bestHasFuture && currHasFuture) {
 									throw std::runtime_error(
 										"Failed to resolve non-functionality, both outputs have perspective");
-								} else if (currHasFuture) continue;		// do not write
+								} else if (currHasFuture) {
+									words.release(output);	   // do not write
+									continue;
+								}
 							}
 						}
+						if (this->output.contains(newIndex)) words.release(this->output[newIndex]);
 						this->output[newIndex] = output;
 						bestOutToKeep		   = q;
 					}
@@ -193,9 +219,8 @@ class SSFT {
 				queue.push(newIndex);
 			}
 
-			for (const auto &ref : currentTransitions) {
-				auto &[_, rhs]		 = ref.get();
-				auto &[outputID, to] = rhs;
+			for (const auto &s : currentLetters) {
+				auto &[outputID, to] = transitions.find({current, s})->second;
 				if (stateRemap[to] == -1) {
 					std::cerr << "Error: state remap failed for state " << to << std::endl;
 					continue;
@@ -253,9 +278,16 @@ class SSFT {
 
 			// clear temporary data to conserve memory allocation
 			nextStates.clear();
-			currentTransitions.clear();
+			currentLetters.clear();
 			temporaryWords.clear();
+
+			// outputs shortened by replaceWithSubstr or replaced by another one leave dead letters behind
+			if (words.canReclaim() && words.deadLength() > COMPACT_THRESHOLD &&
+				words.deadLength() > words.totalLength() / 2) {
+				compactWords();
+			}
 		}
+		if (words.canReclaim() && words.deadLength() > 0) compactWords();
 		this->N = states.size();
 
 		// print in dot format
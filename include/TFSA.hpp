@@ -14,21 +14,29 @@
 namespace fl {
 
 // Classical Two-Tape Finite State Automaton (TFSA)
+// allocates from the memory resource it is constructed with, like FST
 template <class Letter>
 class TFSA {
    public:
-	using State	   = unsigned int;
-	using StringID = typename WordSet<Letter>::WordID;
+	using State			 = unsigned int;
+	using StringID		 = typename WordSet<Letter>::WordID;
+	using allocator_type = std::pmr::polymorphic_allocator<>;
 
-	using Map = unordered_multimap<State, std::tuple<Letter, StringID, State>>;
+	using Map = pmr::unordered_multimap<State, std::tuple<Letter, StringID, State>>;
 
 	unsigned int			  N = 0;
-	unordered_set<State> qFirsts;
-	unordered_set<State> qFinals;
+	pmr::unordered_set<State> qFirsts;
+	pmr::unordered_set<State> qFinals;
 	Map						  transitions;
 	WordSet<Letter>			  words;
 
-	unordered_set<StringID> f_eps{};
+	pmr::unordered_set<StringID> f_eps;
+
+	TFSA() : TFSA(allocator_type()) {}
+	explicit TFSA(const allocator_type &alloc)
+		: qFirsts(alloc), qFinals(alloc), transitions(alloc), words(alloc), f_eps(alloc) {}
+
+	allocator_type get_allocator() const { return words.get_allocator(); }
 
 	void addTransition(State from, Letter w1, StringID w2, State to) { transitions.insert({from, {w1, w2, to}}); }
 	void addTransition(State from, Letter w1, const std::vector<Letter> w2, State to) {
@@ -71,7 +79,7 @@ class TFSA {
 
 template <class Letter>
 auto expandFST(FST<Letter> &&fst) {
-	TFSA<Letter> expanded;
+	TFSA<Letter> expanded(fst.get_allocator());
 	using State		 = TFSA<Letter>::State;
 	using StringID	 = TFSA<Letter>::StringID;
 	expanded.N		 = fst.N;
@@ -140,27 +148,31 @@ auto removeUpperEpsilonFST(TFSA<Letter> &&fsa) {
 	using State	   = TFSA<Letter>::State;
 	using StringID = TFSA<Letter>::StringID;
 
-	std::stack<int>													 stack;
-	std::vector<bool>												 visited(fsa.N, false);
-	std::vector<std::vector<std::tuple<State, std::vector<Letter>>>> closure(fsa.N);
+	using Word = std::pmr::vector<Letter>;
+
+	const auto												   alloc = fsa.get_allocator();
+	std::stack<int, std::pmr::vector<int>>					   stack(alloc);
+	std::pmr::vector<bool>									   visited(fsa.N, false, alloc);
+	std::pmr::vector<std::pmr::vector<std::tuple<State, Word>>> closure(fsa.N, alloc);
 
 	for (State i = 0; i < fsa.N; ++i) {
 		stack.push(0);
 		visited[i] = true;
-		closure[i].push_back({i, {}});	   // add the state itself with an empty word
+		closure[i].emplace_back(i, Word{});		// add the state itself with an empty word
 		while (!stack.empty()) {
-			auto p					= stack.top();
-			const auto [current, u] = closure[i][p];
+			auto p = stack.top();
 			stack.pop();
+			const State current = std::get<0>(closure[i][p]);
+			const Word	u(std::get<1>(closure[i][p]), alloc);	  // closure[i] grows below
 
 			auto [i1, i2] = fsa.transitions.equal_range(current);
 			for (const auto &[_, value] : std::ranges::subrange(i1, i2)) {
 				const auto &[w1, id2, to] = value;
 				if (w1 == Letter::eps && !visited[to]) {	 // epsilon transition
-					visited[to]	  = true;
-					auto new_word = u;
+					visited[to] = true;
+					Word new_word(u, alloc);
 					new_word.insert(new_word.end(), fsa.words.getWord(id2).begin(), fsa.words.getWord(id2).end());
-					closure[i].push_back({to, std::move(new_word)});
+					closure[i].emplace_back(to, std::move(new_word));
 					stack.push(closure[i].size() - 1);
 				}
 			}
@@ -184,7 +196,8 @@ auto removeUpperEpsilonFST(TFSA<Letter> &&fsa) {
 		return w1 == Letter::eps;	  // remove epsilon transitions
 	});
 
-	typename TFSA<Letter>::Map new_transitions;
+	typename TFSA<Letter>::Map new_transitions(alloc);
+	Word					   new_word(alloc);
 	for (State q1 = 0; q1 < fsa.N; ++q1) {
 		for (const auto &[q_, u] : closure[q1]) {
 			auto [i1, i2] = fsa.transitions.equal_range(q_);
@@ -192,7 +205,7 @@ auto removeUpperEpsilonFST(TFSA<Letter> &&fsa) {
 				const auto &[sigma, id2, q__] = value;
 				const auto &v				  = fsa.words.getWord(id2);
 				for (const auto &[q2, w] : closure[q__]) {
-					auto new_word = u;
+					new_word.assign(u.begin(), u.end());
 					new_word.insert(new_word.end(), v.begin(), v.end());
 					new_word.insert(new_word.end(), w.begin(), w.end());
 					StringID new_id = fsa.words.addWord(new_word);
@@ -208,6 +221,7 @@ auto removeUpperEpsilonFST(TFSA<Letter> &&fsa) {
 
 template <class Letter>
 auto trimFSA(TFSA<Letter> &&fsa) {
+	const auto alloc = fsa.get_allocator();
 	if (fsa.qFinals.empty()) {
 		fsa.N		= 0;
 		fsa.qFirsts = {0};
@@ -218,19 +232,19 @@ auto trimFSA(TFSA<Letter> &&fsa) {
 	}
 	using State	   = FST<Letter>::State;
 	using StringID = FST<Letter>::StringID;
-	std::vector<bool> visited_back(fsa.N, false);
-	std::vector<bool> visited_forw(fsa.N, false);
+	std::pmr::vector<bool> visited_back(fsa.N, false, alloc);
+	std::pmr::vector<bool> visited_forw(fsa.N, false, alloc);
 
 	{
-		auto						   &forwardTransitions = fsa.transitions;
-		std::vector<std::vector<State>> backwardTransitions;
+		auto									 &forwardTransitions = fsa.transitions;
+		std::pmr::vector<std::pmr::vector<State>> backwardTransitions(alloc);
 		backwardTransitions.resize(fsa.N);
 		for (const auto &[from, value] : forwardTransitions) {
 			const auto &[_, _, to] = value;
 			backwardTransitions[to].push_back(from);
 		}
 
-		std::vector<State> stack;
+		std::pmr::vector<State> stack(alloc);
 		for (const auto &final : fsa.qFinals) {
 			visited_back[final] = true;
 			stack.push_back(final);
@@ -263,12 +277,12 @@ auto trimFSA(TFSA<Letter> &&fsa) {
 			}
 		}
 	}
-	int				   cnt = 0;
-	std::vector<State> new_map(fsa.N, -1);
+	int						cnt = 0;
+	std::pmr::vector<State> new_map(fsa.N, -1, alloc);
 	for (unsigned int i = 0; i < fsa.N; ++i) {
 		if (visited_back[i] && visited_forw[i]) { new_map[i] = cnt++; }
 	}
-	TFSA<Letter> new_fsa;
+	TFSA<Letter> new_fsa(alloc);
 	new_fsa.N = cnt;
 	new_fsa.qFirsts.reserve(fsa.qFirsts.size());
 	for (const auto &q : fsa.qFirsts) {
@@ -280,7 +294,7 @@ auto trimFSA(TFSA<Letter> &&fsa) {
 		if (new_map[q] != -1u) { new_fsa.qFinals.insert(new_map[q]); }
 	}
 
-	std::vector<bool> words_used(fsa.words.size(), false);
+	std::pmr::vector<bool> words_used(fsa.words.size(), false, alloc);
 	words_used[0] = true;
 	for (const auto &q : fsa.f_eps) {
 		words_used[q] = true;
@@ -290,14 +304,14 @@ auto trimFSA(TFSA<Letter> &&fsa) {
 		if (new_map[from] != -1u && new_map[to] != -1u) { words_used[id] = true; }
 	}
 
-	std::vector<StringID> words_index_map(fsa.words.size(), -1);
+	std::pmr::vector<StringID> words_index_map(fsa.words.size(), -1, alloc);
 	for (size_t i = 0; i < fsa.words.size(); ++i) {
 		if (words_used[i]) {
 			auto id			   = new_fsa.words.addWord(std::move(fsa.words.getWord(i)));
 			words_index_map[i] = id;
 		}
 	}
-	unordered_set<StringID> new_f_eps;
+	pmr::unordered_set<StringID> new_f_eps(alloc);
 	for (const auto &q : fsa.f_eps) {
 		if (words_used[q]) { new_f_eps.insert(words_index_map[q]); }
 	}
@@ -316,9 +330,16 @@ auto trimFSA(TFSA<Letter> &&fsa) {
 	return std::move(new_fsa);
 }
 
+/// every stage allocates from alloc, so the intermediate automata can be released together with the result
+template <class Letter>
+auto realtimeFST(FST<Letter> &&fst, const typename FST<Letter>::allocator_type &alloc) {
+	return trimFSA(removeUpperEpsilonFST(expandFST(removeEpsilonFST(trimFSA(std::move(fst), alloc)))));
+}
+
 template <class Letter>
 auto realtimeFST(FST<Letter> &&fst) {
-	return trimFSA(removeUpperEpsilonFST(expandFST(removeEpsilonFST(trimFSA(std::move(fst))))));
+	const auto alloc = fst.get_allocator();
+	return realtimeFST(std::move(fst), alloc);
 }
 
 template <class Letter>
@@ -330,16 +351,15 @@ auto pseudoDeterminizeFST(TFSA<Letter> &&fst) {
 
 	struct MyHash {
 		using is_transparent = void;
-		constexpr size_t operator()(const BigState &x) const {
-			return std::hash<std::string_view>()(std::string_view(reinterpret_cast<const char *>(x.data()), x.size()));
-		}
+		size_t operator()(const BigState &x) const { return hashSpan(std::span<const State>(x)); }
 	};
 
-	TFSA<Letter>										dfa;
-	std::vector<std::reference_wrapper<const BigState>> states;
-	unordered_map<BigState, State, MyHash>			state_map;
-	std::queue<State>									queue;
-	UniqueWordSet<Letter>								secondTapeWords;
+	const auto							   alloc = fst.get_allocator();
+	TFSA<Letter>						   dfa(alloc);
+	std::vector<BigState>				   states;
+	unordered_map<BigState, State, MyHash> state_map;
+	std::queue<State>					   queue;
+	UniqueWordSet<Letter>				   secondTapeWords(alloc);
 
 	auto getStateID = [&](BigState &&bs) -> std::pair<State, bool> {
 		std::ranges::sort(bs);
@@ -354,8 +374,9 @@ auto pseudoDeterminizeFST(TFSA<Letter> &&fst) {
 					break;
 				}
 			}
-			auto [it, _] = state_map.emplace(std::move(bs), new_id);
-			states.emplace_back(it->first);
+			// the map moves its keys when it grows, so states keeps its own copy
+			states.push_back(bs);
+			state_map.emplace(std::move(bs), new_id);
 			// check if any of the states in bs is final
 			return {new_id, true};
 		} else {
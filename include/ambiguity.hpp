@@ -1,65 +1,49 @@
 #pragma once
 
-#include <stack>
 #include "FST.hpp"
+#include "graph.hpp"
 
 namespace fl {
 
+/// the subgraph of the transitions with empty input <\varepsilon, w>
 template <class Letter>
-void tarjan(int u, const typename FST<Letter>::Map &transitions);
-
-static int				 foundat = 1, sccIndex = 0;
-static std::vector<int>	 scc;
-static std::vector<int>	 disc, low;		// init disc to -1
-static std::vector<bool> onstack;		// init to 0
-
-template <class Letter>
-void tarjan(int u, const typename FST<Letter>::Map &transitions) {
-	static std::stack<int> st;
-
-	disc[u] = low[u] = foundat++;
-	st.push(u);
-	onstack[u]	   = true;
-	auto [it, end] = transitions.equal_range(u);
-	for (auto iit = it; iit != end; ++iit) {
-		auto &[id1, id2, i] = iit->second;
-		if (id1 != 0) continue;
-		if (disc[i] == -1) {
-			tarjan<Letter>(i, transitions);
-			low[u] = std::min(low[u], low[i]);
-		} else if (onstack[i]) low[u] = std::min(low[u], disc[i]);
+CSRGraph epsilonInputGraph(const FST<Letter> &fst) {
+	CSRGraph graph;
+	graph.offsets.assign(fst.N + 1, 0);
+	for (const auto &[from, rhs] : fst.transitions) {
+		const auto &[id1, id2, to] = rhs;
+		if (id1 == 0) ++graph.offsets[from + 1];
 	}
-	if (disc[u] == low[u]) {
-		while (1) {
-			int v = st.top();
-			st.pop();
-			onstack[v] = false;
-			scc[v]	   = sccIndex;
-			if (u == v) break;
-		}
-		++sccIndex;
+	for (std::size_t q = 0; q < fst.N; ++q) {
+		graph.offsets[q + 1] += graph.offsets[q];
 	}
+
+	std::vector<std::size_t> next(graph.offsets.begin(), graph.offsets.end() - 1);
+	graph.targets.resize(graph.offsets.back());
+	for (const auto &[from, rhs] : fst.transitions) {
+		const auto &[id1, id2, to] = rhs;
+		if (id1 == 0) graph.targets[next[from]++] = to;
+	}
+	return graph;
 }
 
+/**
+ * @brief Tests if the FST is infinitely ambiguous, i.e. if it has a cycle of transitions with empty input that produces
+ * some output. Such a cycle exists iff some <\varepsilon, w> transition with nonempty w connects two states in the
+ * same strongly connected component of the subgraph of transitions with empty input.
+ *
+ * Keeps no state between calls, so it is safe to run concurrently.
+ */
 template <class Letter>
 bool testInfiniteAmbiguity(const FST<Letter> &fst) {
-	// tarjan algorithm to find strongly connected components
-	// we search in the subgraph with transitions only <\varepsilon, w>
-
 	if (fst.transitions.empty()) return false;
 
-	disc.assign(fst.N, -1);
-	low.assign(fst.N, -1);
-	onstack.assign(fst.N, false);
-	scc.assign(fst.N, -1);
-
-	tarjan<Letter>(0, fst.transitions);
+	const SCCs scc = findSCCs(epsilonInputGraph(fst));
 
 	for (const auto &[k, v] : fst.transitions) {
 		auto &[id1, id2, i] = v;
 		if (id1 != 0 || id2 == 0) continue;		// transition is (\varepsilon, w)
-		if (i == k) return true;
-		if (i != k && scc[i] == scc[k] && scc[i] != -1) {
+		if (scc.component[i] == scc.component[k]) {
 			return true;	 // found a cycle in the epsilon transitions
 		}
 	}
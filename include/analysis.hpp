@@ -0,0 +1,106 @@
+#pragma once
+
+#include "FST.hpp"
+#include "TFSA.hpp"
+#include "ambiguity.hpp"
+#include "functionality.hpp"
+
+namespace fl {
+
+/// properties of a transducer computed by analyze
+struct AnalysisReport {
+	bool infinitelyAmbiguous = false;
+	bool functional			 = false;
+	bool boundedVariation	 = false;	  // only decided for functional transducers, where it is the twins property
+
+	std::size_t pairs = 0;	   // accessible pairs of states in the squared automaton
+	std::size_t edges = 0;	   // transitions between them
+
+	/// the SSFT constructor will succeed
+	bool determinizable() const { return !infinitelyAmbiguous && functional && boundedVariation; }
+};
+
+/**
+ * @brief Decides functionality and bounded variation of a trimmed real-time TFSA with a single exploration of the
+ * delays in its squared automaton, built once together with the co-accessible pairs.
+ *
+ * A pair of states that can reach a pair of final states with the same input gets the functionality checks of
+ * isFunctional. A loop that changes a delay breaks the twins property, and a functional TFSA never has one between
+ * such pairs, so only when the loop is outside them the search goes on over the co-accessible pairs alone to decide
+ * functionality.
+ */
+template <class Letter>
+AnalysisReport analyze(const TFSA<Letter> &fst) {
+	using Vertex  = CSRGraph::Vertex;
+	using DelayID = typename UniqueWordSet<Letter>::WordID;
+	using Delay	  = std::pair<DelayID, DelayID>;
+
+	AnalysisReport report;
+
+	// check output of empty word
+	int eps_out = -1;
+	for (const auto &q : fst.f_eps) {
+		if (eps_out == -1) {
+			eps_out = q;
+		} else if (!std::ranges::equal(fst.words[q], fst.words[eps_out])) return report;
+	}
+
+	const RealtimeIndex<Letter>	   index(fst);
+	const SquaredAutomaton<Letter> sq(fst, index);
+	const std::vector<bool>		   coFinal = sq.coAccessible(index);
+	const std::size_t			   N	   = fst.N;
+
+	report.pairs = sq.pairs.size();
+	report.edges = sq.graph.targets.size();
+
+	UniqueWordSet<Letter> delays;
+	std::vector<Delay>	  Adm(sq.pairs.size());
+	std::vector<bool>	  hasAdm(sq.pairs.size(), false);
+	bool				  functional = true;
+
+	//  functional(i+1) := ∀(q′, h′) ∈ Dq : (balancible(h′) ∧
+	// ((q′ ∈ F ) → (h′ = (ε, ε))) ∧ (! Adm(i)(q′) → (h′ = Adm(i)(q′))));
+	auto checkFunctional = [&](Vertex v, DelayID u, DelayID w) {
+		if (!coFinal[v]) return true;
+		const auto h_1 = delays[u];
+		const auto h_2 = delays[w];
+		functional &= balancible(h_1, h_2);
+		functional &= !(index.finals[sq.pairs[v] / N] && index.finals[sq.pairs[v] % N]) || (h_1.empty() && h_2.empty());
+		functional &= !hasAdm[v] || Adm[v] == Delay{u, w};
+		Adm[v]	  = {u, w};
+		hasAdm[v] = true;
+		return functional;
+	};
+
+	Vertex changed = propagateDelays(fst, sq, delays, {}, checkFunctional);
+	if (changed != SCCs::NONE && !coFinal[changed]) {
+		hasAdm.assign(hasAdm.size(), false);
+		changed = propagateDelays(fst, sq, delays, coFinal, checkFunctional);
+	} else report.boundedVariation = functional && changed == SCCs::NONE;
+	report.functional = functional && changed == SCCs::NONE;
+
+	dbLog(dbg::LOG_DEBUG, "analyze: functional: ", report.functional, ", bounded variation: ", report.boundedVariation,
+		  ", delays: ", delays.size());
+	return report;
+}
+
+/**
+ * @brief Analyzes an FST and turns it into a trimmed real-time TFSA, unless it is infinitely ambiguous and so has no
+ * real-time equivalent.
+ *
+ * @return the report and the real-time TFSA, which is empty if the FST is infinitely ambiguous
+ */
+template <class Letter>
+std::pair<AnalysisReport, TFSA<Letter>> analyze(FST<Letter> &&fst) {
+	if (testInfiniteAmbiguity(fst)) {
+		AnalysisReport report;
+		report.infinitelyAmbiguous = true;
+		return {report, TFSA<Letter>{}};
+	}
+
+	auto realtime = realtimeFST<Letter>(std::move(fst));
+	auto report	  = analyze(realtime);
+	return {report, std::move(realtime)};
+}
+
+}	  // namespace fl
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace fl {
+
+/**
+ * @brief A set of the numbers 0 .. size - 1, e.g. the symbols of a SymbolTable, packed 64 to a word so that whole sets
+ * can be merged and compared a word at a time
+ */
+class BitSet {
+	std::vector<std::uint64_t> words;
+
+   public:
+	BitSet() = default;
+	explicit BitSet(std::size_t size) : words((size + 63) / 64) {}
+
+	void insert(std::size_t i) { words[i / 64] |= std::uint64_t(1) << (i % 64); }
+	void erase(std::size_t i) { words[i / 64] &= ~(std::uint64_t(1) << (i % 64)); }
+	bool contains(std::size_t i) const { return (words[i / 64] >> (i % 64)) & 1; }
+
+	/// adds the numbers in other, a set of the same size, and returns whether any of them was not here yet
+	bool merge(const BitSet &other) {
+		std::uint64_t added = 0;
+		for (std::size_t w = 0; w < words.size(); ++w) {
+			added |= other.words[w] & ~words[w];
+			words[w] |= other.words[w];
+		}
+		return added != 0;
+	}
+
+	void clear() { std::fill(words.begin(), words.end(), 0); }
+
+	bool empty() const {
+		for (const auto w : words) {
+			if (w) return false;
+		}
+		return true;
+	}
+
+	std::size_t count() const {
+		std::size_t result = 0;
+		for (const auto w : words) {
+			result += std::popcount(w);
+		}
+		return result;
+	}
+
+	/// calls f with every number in the set, in increasing order
+	template <class F>
+	void forEach(F &&f) const {
+		for (std::size_t w = 0; w < words.size(); ++w) {
+			for (std::uint64_t bits = words[w]; bits; bits &= bits - 1) {
+				f(w * 64 + std::countr_zero(bits));
+			}
+		}
+	}
+
+	bool operator==(const BitSet &other) const = default;
+};
+
+}	  // namespace fl
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace fl {
+
+/**
+ * @brief Appends trivially copyable values to a byte buffer in the native byte order. The blobs it writes are meant to
+ * be read back by the same build, on the same machine, e.g. from a cache file
+ */
+class BlobWriter {
+	std::vector<std::byte> bytes;
+
+   public:
+	template <class T>
+		requires std::is_trivially_copyable_v<T>
+	void write(const T &value) {
+		const auto *p = reinterpret_cast<const std::byte *>(&value);
+		bytes.insert(bytes.end(), p, p + sizeof(T));
+	}
+
+	template <class T>
+		requires std::is_trivially_copyable_v<T>
+	void writeVector(std::span<const T> values) {
+		write(std::uint64_t(values.size()));
+		const auto *p = reinterpret_cast<const std::byte *>(values.data());
+		bytes.insert(bytes.end(), p, p + values.size_bytes());
+	}
+
+	std::vector<std::byte> take() { return std::move(bytes); }
+};
+
+/**
+ * @brief Reads back what a BlobWriter wrote. Reading past the end does not throw, it makes the reader fail and
+ * return zeroes, so a truncated blob can be checked for once at the end
+ */
+class BlobReader {
+	std::span<const std::byte> bytes;
+	bool					   failed = false;
+
+   public:
+	explicit BlobReader(std::span<const std::byte> bytes) : bytes(bytes) {}
+
+	template <class T>
+		requires std::is_trivially_copyable_v<T>
+	T read() {
+		T value{};
+		if (bytes.size() < sizeof(T)) {
+			failed = true;
+			return value;
+		}
+		std::memcpy(&value, bytes.data(), sizeof(T));
+		bytes = bytes.subspan(sizeof(T));
+		return value;
+	}
+
+	template <class T>
+		requires std::is_trivially_copyable_v<T>
+	std::vector<T> readVector() {
+		const auto count = read<std::uint64_t>();
+		if (failed || count > bytes.size() / sizeof(T)) {
+			failed = true;
+			return {};
+		}
+		std::vector<T> values(count);
+		std::memcpy(values.data(), bytes.data(), count * sizeof(T));
+		bytes = bytes.subspan(count * sizeof(T));
+		return values;
+	}
+
+	bool ok() const { return !failed; }
+	bool atEnd() const { return bytes.empty(); }
+};
+
+/// the contents of a file, empty if it can not be read
+inline std::vector<std::byte> readBlob(const std::filesystem::path &file) {
+	std::ifstream in(file, std::ios::binary | std::ios::ate);
+	if (!in) return {};
+	std::vector<std::byte> bytes(std::size_t(in.tellg()));
+	in.seekg(0);
+	if (!in.read(reinterpret_cast<char *>(bytes.data()), bytes.size())) return {};
+	return bytes;
+}
+
+/// writes a blob to a file through a temporary one, so readers never see half of it. Returns whether it succeeded
+inline bool writeBlob(const std::filesystem::path &file, std::span<const std::byte> bytes) {
+	std::filesystem::path temporary = file;
+	temporary += ".tmp";
+	{
+		std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+		if (!out.write(reinterpret_cast<const char *>(bytes.data()), bytes.size())) return false;
+	}
+	std::error_code error;
+	std::filesystem::rename(temporary, file, error);
+	return !error;
+}
+
+}	  // namespace fl
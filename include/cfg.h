@@ -1,14 +1,18 @@
 #pragma once
 
 #include <functional>
+#include <span>
+#include <tuple>
 #include <vector>
 #include <iostream>
 #include <cassert>
 
+#include "bitset.hpp"
 #include "concepts.hpp"
 #include "hashing.hpp"
 #include "datastructures.hpp"
 #include "formatting.hpp"
+#include "symbol_table.hpp"
 
 namespace fl {
 
@@ -79,6 +83,189 @@ class CFG {
 	Letter										  start;
 	Letter										  eof = Letter::eof;
 
+   private:
+	/**
+	 * @brief The rules of the grammar over the dense symbols of a SymbolTable, with all right sides in one array. The
+	 * nullable, FIRST and FOLLOW fixpoints run on it as worklists over the dependencies between symbols, with the sets
+	 * as bitsets over the terminals, so a symbol is looked at again only when a set it depends on has grown
+	 */
+	struct DenseRules {
+		using Symbol = typename SymbolTable<Letter>::Symbol;
+
+		SymbolTable<Letter>		   symbols;
+		std::vector<Symbol>		   lhs;
+		std::vector<std::uint32_t> begin;	  // the right side of rule r is rhs[begin[r] .. begin[r + 1])
+		std::vector<Symbol>		   rhs;
+
+		explicit DenseRules(const CFG &g) : symbols(g) {
+			begin.push_back(0);
+			for (const auto &[A, v] : g.rules) {
+				lhs.push_back(symbols.add(A));
+				for (const auto l : v) {
+					rhs.push_back(symbols.add(l));
+				}
+				begin.push_back(rhs.size());
+			}
+		}
+
+		std::size_t				ruleCount() const { return lhs.size(); }
+		std::span<const Symbol> production(std::size_t r) const {
+			return std::span(rhs).subspan(begin[r], begin[r + 1] - begin[r]);
+		}
+
+		BitSet fromMap(const fl::unordered_map<Letter, bool> &nullable) const {
+			BitSet result(symbols.size());
+			for (const auto &[l, isNullable] : nullable) {
+				if (isNullable && symbols.contains(l)) result.insert(symbols[l]);
+			}
+			return result;
+		}
+
+		BitSet fromSet(const fl::unordered_set<Letter> &set) const {
+			BitSet result(symbols.terminalCount());
+			for (const auto l : set) {
+				if (Symbol s = symbols[l]; s != symbols.none && symbols.isTerminal(s)) result.insert(s);
+			}
+			return result;
+		}
+
+		fl::unordered_set<Letter> toSet(const BitSet &set) const {
+			fl::unordered_set<Letter> result;
+			set.forEach([&](std::size_t s) { result.insert(symbols.letter(s)); });
+			return result;
+		}
+
+		/// a rule becomes nullable when the last symbol on its right side that was not known to be nullable becomes so
+		BitSet nullable() const {
+			BitSet									result(symbols.size());
+			std::vector<std::uint32_t>				pending(ruleCount());	  // symbols left to become nullable
+			std::vector<std::vector<std::uint32_t>> uses(symbols.size());	  // the rules with a symbol on the right
+			std::vector<Symbol>						work;
+
+			auto found = [&](Symbol A) {
+				if (result.contains(A)) return;
+				result.insert(A);
+				work.push_back(A);
+			};
+			for (std::size_t r = 0; r < ruleCount(); ++r) {
+				pending[r] = begin[r + 1] - begin[r];
+				for (const Symbol s : production(r)) {
+					uses[s].push_back(r);
+				}
+				if (pending[r] == 0) found(lhs[r]);
+			}
+			while (!work.empty()) {
+				const Symbol s = work.back();
+				work.pop_back();
+				for (const auto r : uses[s]) {
+					if (--pending[r] == 0) found(lhs[r]);
+				}
+			}
+			return result;
+		}
+
+		/// FIRST(A) includes FIRST(X) for every X in a nullable prefix of a right side of A, or the symbol after it
+		std::vector<BitSet> first(const BitSet &nullable) const {
+			std::vector<BitSet>				 result(symbols.size(), BitSet(symbols.terminalCount()));
+			std::vector<std::vector<Symbol>> includedBy(symbols.size());
+			for (Symbol t = 0; t < symbols.terminalCount(); ++t) {
+				result[t].insert(t);
+			}
+			for (std::size_t r = 0; r < ruleCount(); ++r) {
+				for (const Symbol X : production(r)) {
+					if (X != lhs[r]) includedBy[X].push_back(lhs[r]);
+					if (!nullable.contains(X)) break;
+				}
+			}
+			propagate(result, includedBy);
+			return result;
+		}
+
+		/**
+		 * FOLLOW(B) includes FIRST of what comes after B in a rule, which is computed once per rule from right to
+		 * left, and FOLLOW(A) if that is nullable. FOLLOW(start) includes eof
+		 */
+		std::vector<BitSet> follow(const BitSet &nullable, const std::vector<BitSet> &first, const Letter start,
+								   const Letter eof) const {
+			std::vector<BitSet>				 result(symbols.size(), BitSet(symbols.terminalCount()));
+			std::vector<std::vector<Symbol>> includedBy(symbols.size());
+			BitSet							 suffix(symbols.terminalCount());
+
+			const Symbol s = symbols[start], e = symbols[eof];
+			if (s != symbols.none && e != symbols.none && symbols.isTerminal(e)) result[s].insert(e);
+			for (std::size_t r = 0; r < ruleCount(); ++r) {
+				const Symbol A				= lhs[r];
+				bool		 suffixNullable = true;
+				suffix.clear();
+				for (const Symbol X : production(r) | std::views::reverse) {
+					if (!symbols.isTerminal(X)) {
+						result[X].merge(suffix);
+						if (suffixNullable && X != A) includedBy[A].push_back(X);
+					}
+					if (!nullable.contains(X)) {
+						suffix.clear();
+						suffixNullable = false;
+					}
+					suffix.merge(first[X]);
+				}
+			}
+			propagate(result, includedBy);
+			return result;
+		}
+
+		/// merges sets[X] into sets[Y] for every Y in includedBy[X] until no set grows
+		static void propagate(std::vector<BitSet> &sets, const std::vector<std::vector<Symbol>> &includedBy) {
+			std::vector<Symbol> work(sets.size());
+			std::vector<bool>	queued(sets.size(), true);
+			for (std::size_t s = 0; s < sets.size(); ++s) {
+				work[s] = sets.size() - 1 - s;
+			}
+			while (!work.empty()) {
+				const Symbol X = work.back();
+				work.pop_back();
+				queued[X] = false;
+				for (const Symbol Y : includedBy[X]) {
+					if (sets[Y].merge(sets[X]) && !queued[Y]) {
+						queued[Y] = true;
+						work.push_back(Y);
+					}
+				}
+			}
+		}
+	};
+
+	// the sets computed on d, as maps from the letters of the grammar
+
+	fl::unordered_map<Letter, bool> findNullables(const DenseRules &d, const BitSet &nullable) const {
+		fl::unordered_map<Letter, bool> res;
+		for (std::size_t s = 0; s < d.symbols.size(); ++s) {
+			res.insert({d.symbols.letter(s), nullable.contains(s)});
+		}
+		return res;
+	}
+
+	fl::unordered_map<Letter, fl::unordered_set<Letter>> findFirsts(const DenseRules &d,
+																	 const std::vector<BitSet> &sets) const {
+		fl::unordered_map<Letter, fl::unordered_set<Letter>> first;
+		for (Letter l : terminals) {
+			first.insert({l, {l}});
+		}
+		for (Letter l : nonTerminals) {
+			first.insert({l, d.toSet(sets[d.symbols[l]])});
+		}
+		return first;
+	}
+
+	fl::unordered_map<Letter, fl::unordered_set<Letter>> findFollows(const DenseRules &d,
+																	  const std::vector<BitSet> &sets) const {
+		fl::unordered_map<Letter, fl::unordered_set<Letter>> follow;
+		for (Letter l : nonTerminals) {
+			follow.insert({l, d.toSet(sets[d.symbols[l]])});
+		}
+		follow.find(start)->second.insert(eof);
+		return follow;
+	}
+
    public:
 	CFG(const Letter &start, const Letter &eof) : start(start), eof(eof) {
 		terminals.insert(eof);
@@ -91,38 +278,8 @@ class CFG {
 	 * @return fl::unordered_map<Letter, bool>
 	 */
 	fl::unordered_map<Letter, bool> findNullables() const {
-		fl::unordered_map<Letter, bool> res;
-
-		for (const auto &[k, v] : rules) {
-			if (v.empty()) { res.insert({k, true}); }
-		}
-		for (Letter l : terminals) {
-			res.insert({l, false});
-		}
-
-		std::size_t prevSize = 0;
-		while (prevSize != res.size()) {
-			prevSize = res.size();
-
-			for (const auto &[k, v] : rules) {
-				if (res.contains(k)) continue;
-
-				bool isNullable = true;
-				bool isKnown	= true;
-				for (Letter l : v) {
-					bool contains = res.contains(l);
-					if (contains && !res.find(l)->second) {
-						res.insert({k, false});
-						isNullable = false;
-						break;
-					}
-					isKnown = isKnown && contains;
-				}
-				if (isNullable && isKnown) { res.insert({k, true}); }
-			}
-		}
-
-		return std::move(res);
+		const DenseRules d(*this);
+		return findNullables(d, d.nullable());
 	}
 
 	/**
@@ -152,42 +309,8 @@ class CFG {
 	 */
 	fl::unordered_map<Letter, fl::unordered_set<Letter>> findFirsts(
 		const fl::unordered_map<Letter, bool> &nullable) const {
-		fl::unordered_map<Letter, fl::unordered_set<Letter>> first;
-
-		for (Letter l : terminals) {
-			first.insert({l, {l}});
-		}
-		for (Letter l : nonTerminals) {
-			first.insert({l, {}});
-		}
-
-		bool change = true;
-		while (change) {
-			change = false;
-			for (const auto &[k, v] : rules) {
-				auto &firstSet = first.find(k)->second;
-				if (!v.empty() && first.contains(v[0])) {
-					for (const auto l : first.find(v[0])->second) {
-						if (!firstSet.contains(l)) {
-							firstSet.insert(l);
-							change = true;
-						}
-					}
-				}
-				for (size_t i = 0; i < v.size(); ++i) {
-					if (i)
-						for (const auto l : first.find(v[i])->second) {
-							if (!firstSet.contains(l)) {
-								firstSet.insert(l);
-								change = true;
-							}
-						}
-					if (!nullable.find(v[i])->second) break;
-				}
-			}
-		}
-
-		return first;
+		const DenseRules d(*this);
+		return findFirsts(d, d.first(d.fromMap(nullable)));
 	}
 	/**
 	 * @brief checks if x is in the FIRST set for the word w
@@ -240,49 +363,28 @@ class CFG {
 	fl::unordered_map<Letter, fl::unordered_set<Letter>> findFollows(
 		const fl::unordered_map<Letter, bool>						 &nullable,
 		const fl::unordered_map<Letter, fl::unordered_set<Letter>> &first) const {
-		fl::unordered_map<Letter, fl::unordered_set<Letter>> follow;
-
-		for (Letter l : nonTerminals) {
-			follow.insert({l, {}});
-		}
-
-		follow.find(start)->second.insert(eof);
-
-		bool change = true;
-		while (change) {
-			change = false;
-			for (const auto &[A, v] : rules) {
-				for (size_t i = 0; i < v.size(); ++i) {
-					if (!nonTerminals.contains(v[i])) continue;
-					// productions of type A -> aBb
-					// where A and B are nonterminals and a and b are words
-					auto	   &followB = follow.find(v[i])->second;
-					const auto	b		= std::vector<Letter>{v.begin() + i + 1, v.end()};
-					const auto &firstb	= this->first(b, nullable, first);
-
-					if (!b.empty()) {
-						for (const auto l : firstb) {
-							if (!followB.contains(l)) {
-								followB.insert(l);
-								change = true;
-							}
-						}
-					}
-
-					if (this->nullable(b, nullable)) {
-						const auto followA = follow.find(A)->second;
-						for (const auto l : followA) {
-							if (!followB.contains(l)) {
-								followB.insert(l);
-								change = true;
-							}
-						}
-					}
-				}
-			}
+		const DenseRules d(*this);
+		std::vector<BitSet> firstSets(d.symbols.size(), BitSet(d.symbols.terminalCount()));
+		for (std::size_t s = 0; s < d.symbols.size(); ++s) {
+			if (auto it = first.find(d.symbols.letter(s)); it != first.end()) firstSets[s] = d.fromSet(it->second);
 		}
+		return findFollows(d, d.follow(d.fromMap(nullable), firstSets, start, eof));
+	}
 
-		return follow;
+	/**
+	 * @brief Computes the nullable, FIRST and FOLLOW sets together, on one dense copy of the rules, which the three
+	 * separate calls would each build again
+	 *
+	 * @return the results of findNullables, findFirsts and findFollows
+	 */
+	std::tuple<fl::unordered_map<Letter, bool>, fl::unordered_map<Letter, fl::unordered_set<Letter>>,
+			   fl::unordered_map<Letter, fl::unordered_set<Letter>>>
+	findSets() const {
+		const DenseRules d(*this);
+		const BitSet	 nullable = d.nullable();
+		const auto		 first	  = d.first(nullable);
+		return {findNullables(d, nullable), findFirsts(d, first),
+				findFollows(d, d.follow(nullable, first, start, eof))};
 	}
 
 	CFG() {}
@@ -302,9 +404,7 @@ class CFG {
 			std::cout << std::endl;
 		}
 
-		const auto nullable = findNullables();
-		const auto first	= findFirsts(nullable);
-		const auto follow	= findFollows(nullable, first);
+		const auto [nullable, first, follow] = findSets();
 
 		for (const auto &[A, v] : rules) {
 			if (v.empty()) {
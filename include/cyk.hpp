@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "bitset.hpp"
+#include "cfg.h"
+#include "grammar_transforms.hpp"
+#include "symbol_table.hpp"
+
+namespace fl {
+
+/**
+ * @brief A CYK recognizer for Context-Free Grammars, which brings the grammar to Chomsky normal form first. For a word
+ * of length n and a grammar with R rules A -> BC it takes O(n^3 R / 64) time, for any grammar and any word, and
+ * O(n^2 R / 64) memory, so it is meant for short inputs.
+ *
+ * A cell of the table, the non-terminals that derive a span of the word, is kept as two bit sets over the rules A ->
+ * BC: the rules that have one of the non-terminals as B, and those that have one as C. The rules that derive a span
+ * are then the OR over the ways to split it of the AND of the two, which goes 64 rules at a time in a loop simple
+ * enough for the compiler to vectorize.
+ *
+ * @tparam Letter - type of the symbols in the alphabet
+ */
+template <isLetter Letter>
+class CYKParser {
+	using Symbol				 = typename SymbolTable<Letter>::Symbol;
+	static constexpr Symbol none = SymbolTable<Letter>::none;
+
+	CFG<Letter> grammar;	 // in Chomsky normal form
+
+	SymbolTable<Letter>		   symbols;
+	std::size_t				   words = 0;	 // the number of 64-bit words in a set of binary rules
+	std::vector<Symbol>		   lhs;			 // [binary rule] -> index of the non-terminal on the left
+	std::vector<std::uint64_t> firstOf;		 // [non-terminal * words] -> the binary rules with it as B
+	std::vector<std::uint64_t> secondOf;	 // [non-terminal * words] -> the binary rules with it as C
+	std::vector<std::uint64_t> startRules;	 // the binary rules of the start symbol
+	std::vector<BitSet>		   derives;		 // [terminal] -> the non-terminals A with A -> terminal
+	bool					   derivesEps = false;
+
+	Symbol nonTerminal(const Letter l) const { return symbols.find(l) - symbols.terminalCount(); }
+
+	/// makes letters after every letter of g without registering them, like Token::createDependentToken would, so
+	/// Letter::size stays as it is for the parsers built before
+	static auto unusedLetters(const CFG<Letter> &g) {
+		std::size_t next = std::max({Letter::size, std::size_t(g.start) + 1, std::size_t(g.eof) + 1,
+									 std::size_t(Letter::eps) + 1, std::size_t(Letter::eof) + 1});
+		for (const auto l : g.terminals) {
+			next = std::max(next, std::size_t(l) + 1);
+		}
+		for (const auto &[A, v] : g.rules) {
+			next = std::max(next, std::size_t(A) + 1);
+			for (const auto l : v) {
+				next = std::max(next, std::size_t(l) + 1);
+			}
+		}
+		return [next](const Letter) mutable { return Letter(next++); };
+	}
+
+	void build() {
+		// every letter on a right side that is not a non-terminal is read as a terminal
+		std::vector<Letter> alphabet(grammar.terminals.begin(), grammar.terminals.end());
+		for (const auto &[A, v] : grammar.rules) {
+			for (const auto l : v) {
+				if (!grammar.nonTerminals.contains(l) && !grammar.terminals.contains(l)) alphabet.push_back(l);
+			}
+		}
+		symbols = SymbolTable<Letter>(alphabet);
+		for (const auto l : grammar.nonTerminals) {
+			symbols.add(l);
+		}
+		symbols.add(grammar.start);
+
+		const std::size_t nonTerminals = symbols.size() - symbols.terminalCount();
+		std::size_t		  binary	   = 0;
+		for (const auto &[A, v] : grammar.rules) {
+			binary += v.size() == 2;
+		}
+		words = (binary + 63) / 64;
+		firstOf.assign(nonTerminals * words, 0);
+		secondOf.assign(nonTerminals * words, 0);
+		startRules.assign(words, 0);
+		derives.assign(symbols.terminalCount(), BitSet(nonTerminals));
+
+		for (const auto &[A, v] : grammar.rules) {
+			if (v.empty()) derivesEps = true;
+			else if (v.size() == 1) derives[symbols.find(v[0])].insert(nonTerminal(A));
+			else {
+				const std::size_t	r	 = lhs.size();
+				const std::uint64_t mask = std::uint64_t(1) << (r % 64);
+				lhs.push_back(nonTerminal(A));
+				firstOf[nonTerminal(v[0]) * words + r / 64] |= mask;
+				secondOf[nonTerminal(v[1]) * words + r / 64] |= mask;
+				if (A == grammar.start) startRules[r / 64] |= mask;
+			}
+		}
+	}
+
+   public:
+	bool expect_eof = false;
+
+	template <class Fresh>
+	CYKParser(const CFG<Letter> &g, Fresh &&fresh) : grammar(toChomskyNormalForm(g, fresh)) {
+		build();
+	}
+
+	/// the non-terminals of the normal form stay inside the recognizer, and print as numbers in getGrammar()
+	CYKParser(const CFG<Letter> &g)
+		requires transforms::hasDependentLetters<Letter> && std::is_constructible_v<Letter, std::size_t>
+		: grammar(toChomskyNormalForm(g, unusedLetters(g))) {
+		build();
+	}
+
+	bool recognize(const std::vector<Letter> &word) const {
+		if (expect_eof && (word.empty() || word.back() != grammar.eof)) return false;
+		const std::size_t n = word.size() - expect_eof;
+		if (n == 0) return derivesEps;
+
+		// the rule sets of the span [i, i + length) by its start, and of the span [j - length, j) by its end, so that
+		// the splits of a span go through both in order
+		const std::size_t		   rows = n + 1;
+		std::vector<std::uint64_t> byStart(rows * rows * words), byEnd(rows * rows * words);
+		auto					   add = [&](const std::size_t i, const std::size_t length, const BitSet &cell) {
+			  std::uint64_t *first	= byStart.data() + (i * rows + length) * words;
+			  std::uint64_t *second = byEnd.data() + ((i + length) * rows + length) * words;
+			  cell.forEach([&](const std::size_t A) {
+				  for (std::size_t w = 0; w < words; ++w) {
+					  first[w] |= firstOf[A * words + w];
+					  second[w] |= secondOf[A * words + w];
+				  }
+			  });
+		};
+
+		const Symbol start = nonTerminal(grammar.start);
+		for (std::size_t i = 0; i < n; ++i) {
+			const Symbol t = symbols.find(word[i]);
+			if (t == none || !symbols.isTerminal(t)) return false;
+			if (n == 1) return derives[t].contains(start);
+			add(i, 1, derives[t]);
+		}
+
+		std::vector<std::uint64_t> rules(words);
+		BitSet					   cell(symbols.size() - symbols.terminalCount());
+		for (std::size_t length = 2; length <= n; ++length) {
+			for (std::size_t i = 0, j = length; j <= n; ++i, ++j) {
+				std::fill(rules.begin(), rules.end(), 0);
+				for (std::size_t k = i + 1; k < j; ++k) {
+					const std::uint64_t *first	= byStart.data() + (i * rows + k - i) * words;
+					const std::uint64_t *second = byEnd.data() + (j * rows + j - k) * words;
+					for (std::size_t w = 0; w < words; ++w) {
+						rules[w] |= first[w] & second[w];
+					}
+				}
+
+				if (length == n) {
+					for (std::size_t w = 0; w < words; ++w) {
+						if (rules[w] & startRules[w]) return true;
+					}
+					return false;
+				}
+				cell.clear();
+				for (std::size_t w = 0; w < words; ++w) {
+					for (std::uint64_t bits = rules[w]; bits; bits &= bits - 1) {
+						cell.insert(lhs[w * 64 + std::countr_zero(bits)]);
+					}
+				}
+				add(i, length, cell);
+			}
+		}
+		return false;
+	}
+
+	template <typename U = Letter>
+		requires std::is_constructible_v<Letter, char>
+	bool recognize(const std::string &word) const {
+		return recognize(std::vector<Letter>(word.begin(), word.end()));
+	}
+
+	/// the grammar in Chomsky normal form
+	const CFG<Letter> &getGrammar() const { return grammar; }
+};
+
+}	  // namespace fl
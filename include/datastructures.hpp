@@ -1,16 +1,30 @@
 #pragma once
+#include <memory_resource>
 #include <unordered_map>
-#include <unordered_set>
 
+#include "flat_hash.hpp"
 #include "hashing.hpp"
 
 namespace fl {
 template <class K, class V, class H = fl::hash<K>>
-using unordered_map = std::unordered_map<K, V, H>;
+using unordered_map = FlatHashMap<K, V, H>;
 
 template <class K, class H = fl::hash<K>>
-using unordered_set = std::unordered_set<K, H>;
+using unordered_set = FlatHashSet<K, H>;
 
+// equal_range needs the elements with equal keys next to each other, which open addressing does not keep
 template <class K, class V, class H = fl::hash<K>>
 using unordered_multimap = std::unordered_multimap<K, V, H>;
+
+/// the same containers allocating from a std::pmr::memory_resource
+namespace pmr {
+template <class K, class V, class H = fl::hash<K>>
+using unordered_map = FlatHashMap<K, V, H, std::equal_to<K>, std::pmr::polymorphic_allocator<std::pair<const K, V>>>;
+
+template <class K, class H = fl::hash<K>>
+using unordered_set = FlatHashSet<K, H, std::equal_to<K>, std::pmr::polymorphic_allocator<K>>;
+
+template <class K, class V, class H = fl::hash<K>>
+using unordered_multimap = std::pmr::unordered_multimap<K, V, H>;
+}	  // namespace pmr
 }	  // namespace fl
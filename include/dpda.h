@@ -3,13 +3,13 @@
 #include <format>
 #include <string>
 #include <tuple>
-#include <unordered_map>
 #include <vector>
 #include <iostream>
 #include <ranges>
 
 #include "cfg.h"
 #include "concepts.hpp"
+#include "datastructures.hpp"
 #include "hashing.hpp"
 #include "debug.hpp"
 
@@ -25,8 +25,7 @@ template <class State = std::size_t, class Letter = char>
 class DPDA {
    public:
 	using Production = typename CFG<Letter>::Production;
-	using DeltaMap	 = std::unordered_map<std::tuple<State, Letter, Letter>, std::tuple<State, Production>,
-										  fl::hash<std::tuple<State, Letter, Letter>>>;
+	using DeltaMap	 = fl::unordered_map<std::tuple<State, Letter, Letter>, std::tuple<State, Production>>;
 	DeltaMap delta;		/// the transition function
 
 	State qFinal	   = 0;			// the final state
@@ -1,5 +1,15 @@
 #pragma once
+#include <algorithm>
+#include <cstdint>
+#include <ranges>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "bitset.hpp"
 #include "cfg.h"
+#include "parse_forest.hpp"
+#include "symbol_table.hpp"
 #include "utils.h"
 
 namespace fl {
@@ -7,150 +17,569 @@ namespace fl {
 /**
  * @brief An Earley Parser for Context-Free Grammars
  *
+ * The dotted rules of the grammar are numbered, so an item is two integers, and every set of the chart is a vector
+ * that only grows while the set is built. Once a set is done, its items are indexed by the symbol after their dot, so
+ * scanning a terminal and completing a non-terminal look up the items waiting for it instead of going through the
+ * whole set. Nullable non-terminals are skipped over when they are predicted, as Aycock and Horspool suggest, so a
+ * completion never has to look into the set that is being built.
+ *
+ * Completing a right-recursive rule like S -> aS would move every item of the recursion over S again, which makes the
+ * chart quadratic on long lists. With Leo's optimization a completion that has only one item to move, which then is
+ * complete as well, goes straight to the topmost item of that chain instead. The topmost items are memoized per set, so
+ * the recognizer is linear for LR-regular grammars.
+ *
+ * With lookahead on, an item only goes into a set if what is after its dot can derive eps or start with the next token
+ * of the word. Others could never move on, so that leaves out most of the predictions, and items that a scan or a
+ * completion would add only to wait for a different token.
+ *
  * @tparam Letter
  */
 template <isLetter Letter>
 class EarleyParser {
 	CFG<Letter> grammar;
 
+	using Symbol				 = typename SymbolTable<Letter>::Symbol;
+	static constexpr Symbol none = SymbolTable<Letter>::none;
+
+	struct Rule {
+		Symbol		  lhs;
+		std::uint32_t rhs;		 // start of the right side in rhsSymbols
+		std::uint32_t length;
+		std::uint32_t item;		 // the dotted rule with the dot at the start of the right side
+	};
+
+	SymbolTable<Letter>						symbols;
+	std::vector<Rule>						rules;	   // rules[0] is the added start rule S' -> S
+	std::vector<Symbol>						rhsSymbols;
+	std::vector<std::vector<std::uint32_t>> rulesOf;	 // [symbol] -> indices in rules
+	std::vector<std::uint32_t>				dottedRule;	 // [dotted rule] -> index in rules, the next dot is one more
+	std::vector<bool>						nullable;	 // [symbol]
+	std::vector<BitSet>						itemFirst;	 // [dotted rule] -> FIRST of what is after the dot
+	std::vector<bool>						itemNullable;
+
+	/// the next token for a chart that predicts every rule
+	static constexpr Symbol anyToken = none - 1;
+
    public:
-	// struct DottedRule {
-	//	Letter				 lhs;
-	//	std::vector<Letter> *rhs;
-	//	int					 dotPos;
-	//	int					 j;
-	// };
+	static constexpr std::uint32_t noItem = -1;
 
-	bool expect_eof	  = false;
-	bool enable_print = false;
+	/// a dotted rule, and the index of the set its rule was predicted in
+	struct Item {
+		std::uint32_t dotted;
+		std::uint32_t origin;
+		std::uint32_t nextWaiting = noItem;	   // the next item of the same set with the same symbol after its dot
+	};
 
-	using DottedRule = std::tuple<Letter, std::vector<Letter> *, int, int>;
-	EarleyParser(const CFG<Letter> &g) : grammar(g) {}
-
-	auto C(const std::vector<fl::unordered_set<DottedRule>> &R, fl::unordered_set<DottedRule> &R_ip, int i) {
-		fl::unordered_set<DottedRule> &C_s	  = R_ip;
-		bool							added = true;
-
-		// auto &terminals	   = grammar.terminals;
-		auto &nonTerminals = grammar.nonTerminals;
-		auto &rules		   = grammar.rules;
-
-		static fl::unordered_set<DottedRule> C_s1;
-		while (added) {
-			added = false;
-			C_s1.clear();
-			// std::cout << C_s << std::endl;
-			for (auto &[A, w, dotPos, j] : C_s) {
-				auto &β1Xβ2 = *w;
-				if (dotPos < (int)β1Xβ2.size() && nonTerminals.contains(β1Xβ2[dotPos])) {
-					//  { (X → •β, i) | ∃ (A → β1•Xβ2, j) ∈ C(s) and X → β ∈ P }
-					auto &X = β1Xβ2[dotPos];
-					auto  r = rules.equal_range(X);
-					for (auto &[_X, β] : RangeFromPair(r)) {
-						C_s1.insert(DottedRule{X, &β.rhs, 0, i});
-					}
+	struct EarleySet {
+		std::vector<Item> items;
+		// the first item waiting for each symbol, sorted by symbol, the rest of them follow Item::nextWaiting
+		std::vector<std::pair<Symbol, std::uint32_t>> waiting;
+		// [index in waiting] -> the topmost item of Leo's path for the symbol, memoized when it is first needed, with
+		// origin == noItem until then
+		std::vector<Item> transitive;
 
-					// { (A → β1X•β2, j) | ∃ (A → β1X•β2, j) ∈ C(s) and (X → β•, i) ∈ C(s) }
-					for (auto &[X_, w, dotPos_, i_] : C_s) {
-						auto &β = *w;
-						if (X_ == X && dotPos_ == (int)β.size() && i_ == i) {
-							//
-							C_s1.insert({A, &β1Xβ2, dotPos + 1, j});
-						}
-					}
-				}
+		/// the index in waiting of the entry for X
+		std::uint32_t waitingIndex(const Symbol X) const {
+			auto it = std::ranges::lower_bound(waiting, X, {}, &std::pair<Symbol, std::uint32_t>::first);
+			return it != waiting.end() && it->first == X ? it - waiting.begin() : noItem;
+		}
+
+		std::uint32_t firstWaiting(const Symbol X) const {
+			const auto w = waitingIndex(X);
+			return w != noItem ? waiting[w].second : noItem;
+		}
+	};
+
+	/**
+	 * @brief The sets of a chart, and what is needed to build the last one
+	 */
+	struct Chart {
+		std::vector<EarleySet> sets;
+
+		fl::unordered_set<std::uint64_t> seen;		   // the items of the last set, as dotted << 32 | origin
+		BitSet							 predicted;	   // the non-terminals predicted in the last set
+		std::vector<std::uint32_t>		 lastWaiting;  // [symbol] -> the last item of the last set waiting for it
+		std::vector<Symbol>				 waitedFor;	   // the symbols that have an entry in lastWaiting
+
+		bool												 leo  = true;
+		Symbol												 next = anyToken;	 // none at the end of the word
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> path;	  // (set, index in waiting) in transitiveItem
+	};
+
+   private:
+	Symbol afterDot(const std::uint32_t dotted) const {
+		const Rule		 &rule = rules[dottedRule[dotted]];
+		const std::size_t dot  = dotted - rule.item;
+		return dot < rule.length ? rhsSymbols[rule.rhs + dot] : none;
+	}
+
+	bool isTerminal(const Symbol X) const { return symbols.isTerminal(X); }
+
+	void addRule(const Symbol lhs, const std::vector<Letter> &rhs) {
+		rules.push_back({lhs, std::uint32_t(rhsSymbols.size()), std::uint32_t(rhs.size()),
+						 std::uint32_t(dottedRule.size())});
+		for (const auto l : rhs) {
+			rhsSymbols.push_back(symbols.find(l));
+		}
+		dottedRule.insert(dottedRule.end(), rhs.size() + 1, std::uint32_t(rules.size() - 1));
+	}
+
+	/// adds an item to the last set of the chart, unless it is there already or can not go on with the next token
+	void add(Chart &chart, const std::uint32_t dotted, const std::uint32_t origin) const {
+		if (chart.next != anyToken && !itemNullable[dotted] &&
+			(chart.next == none || !itemFirst[dotted].contains(chart.next))) {
+			return;
+		}
+		if (chart.seen.insert(std::uint64_t(dotted) << 32 | origin).second) {
+			chart.sets.back().items.push_back({dotted, origin});
+		}
+	}
+
+	/**
+	 * @brief Finds the topmost item of Leo's deterministic reduction path from the set j, for a non-terminal with the
+	 * index w in its waiting list. There is a path if only one item of the set waits for the non-terminal, and its rule
+	 * ends there. The topmost item is then the one for the left side of that rule from the set the item started in, or
+	 * the item moved over the non-terminal if that set has no path.
+	 *
+	 * @return the topmost item, or one with dotted == noItem if there is no path
+	 */
+	Item transitiveItem(Chart &chart, std::uint32_t j, std::uint32_t w) const {
+		Item top = {noItem, 0};
+		chart.path.clear();
+		while (w != noItem) {
+			auto	   &from = chart.sets[j];
+			const Item &item = from.items[from.waiting[w].second];
+			if (item.nextWaiting != noItem || afterDot(item.dotted + 1) != none) break;
+			if (from.transitive.empty()) from.transitive.assign(from.waiting.size(), {noItem, noItem});
+			if (from.transitive[w].origin != noItem) {
+				top = from.transitive[w];
+				break;
 			}
+			chart.path.push_back({j, w});
+			j = item.origin;
+			w = chart.sets[j].waitingIndex(rules[dottedRule[item.dotted]].lhs);
+		}
+
+		for (const auto &[set, index] : chart.path | std::views::reverse) {
+			const auto &from = chart.sets[set];
+			const Item &item = from.items[from.waiting[index].second];
+			if (top.dotted == noItem) top = {item.dotted + 1, item.origin};
+			chart.sets[set].transitive[index] = top;
+		}
+		return top;
+	}
+
+	/**
+	 * @brief Predicts and completes the items of the last set until nothing new comes up, then indexes them by the
+	 * symbol after their dot
+	 */
+	void close(Chart &chart) const {
+		const std::uint32_t i	= chart.sets.size() - 1;
+		auto			   &set = chart.sets.back();
+
+		for (std::uint32_t k = 0; k < set.items.size(); ++k) {
+			const auto [dotted, origin, _] = set.items[k];
+			const Symbol X				   = afterDot(dotted);
 
-			std::size_t prevSize = C_s.size();
-			C_s.insert(C_s1.begin(), C_s1.end());
-			if (C_s.size() > prevSize) { added = true; }
-			C_s1.clear();
-
-			// {(A → β1X•β2, j) | има β и k < i : ((A → β1•Xβ2, j) ∈ Rk и (X → β•, k) ∈ C(s))}
-			for (auto &[X, w, dotPos, k] : C_s) {
-				auto &β = *w;
-				if (dotPos == (int)β.size()) {
-					// search in R_k
-					for (auto &[A, w, dotPos, j] : R[k]) {
-						auto &β1Xβ2 = *w;
-						if (dotPos < (int)β1Xβ2.size() && X == β1Xβ2[dotPos]) {
-							C_s1.insert({A, &β1Xβ2, dotPos + 1, j});
-						}
+			if (X == none) {
+				// an item that started in this set derives eps, and the items waiting for its non-terminal here were
+				// moved over it when it was predicted
+				if (origin == i) continue;
+				const std::uint32_t w = chart.sets[origin].waitingIndex(rules[dottedRule[dotted]].lhs);
+				if (w == noItem) continue;
+				if (chart.leo) {
+					const Item top = transitiveItem(chart, origin, w);
+					if (top.dotted != noItem) {
+						add(chart, top.dotted, top.origin);
+						continue;
 					}
 				}
+				const auto &from = chart.sets[origin];
+				for (auto v = from.waiting[w].second; v != noItem; v = from.items[v].nextWaiting) {
+					add(chart, from.items[v].dotted + 1, from.items[v].origin);
+				}
+				continue;
 			}
 
-			prevSize = C_s.size();
-			C_s.insert(C_s1.begin(), C_s1.end());
-			if (C_s.size() > prevSize) { added = true; }
-		};
-		return C_s;
-	}
+			auto &last = chart.lastWaiting[X];
+			if (last == noItem) chart.waitedFor.push_back(X);
+			set.items[k].nextWaiting = last;
+			last					 = k;
+			if (isTerminal(X)) continue;
 
-	bool recognize(const std::vector<Letter> &word) {
-		std::vector<fl::unordered_set<DottedRule>> R(word.size() + 1);
-		std::vector<fl::unordered_set<DottedRule>> Rp(word.size() + 1);
+			if (!chart.predicted.contains(X)) {
+				chart.predicted.insert(X);
+				for (const auto r : rulesOf[X]) {
+					add(chart, rules[r].item, i);
+				}
+			}
+			if (nullable[X]) add(chart, dotted + 1, origin);
+		}
 
-		auto r = grammar.rules.equal_range(grammar.start);
-		for (auto &[S, β] : RangeFromPair(r)) {
-			Rp[0].insert(DottedRule{S, &β.rhs, 0, 0});
+		std::ranges::sort(chart.waitedFor);
+		for (const auto X : chart.waitedFor) {
+			set.waiting.push_back({X, chart.lastWaiting[X]});
+			chart.lastWaiting[X] = noItem;
 		}
-		if (enable_print) {
-			std::cout << "R'[0] = ";
-			print(Rp[0]);
-			std::cout << std::endl;
+		chart.waitedFor.clear();
+		chart.predicted.clear();
+		chart.seen.clear();
+	}
+
+	/// starts a new set with the items of the last one that wait for the terminal t, moved over it
+	bool scan(Chart &chart, const Symbol t) const {
+		chart.sets.emplace_back();
+		const auto &from = chart.sets[chart.sets.size() - 2];
+		for (auto w = from.firstWaiting(t); w != noItem; w = from.items[w].nextWaiting) {
+			add(chart, from.items[w].dotted + 1, from.items[w].origin);
 		}
+		return !chart.sets.back().items.empty();
+	}
+
+	Chart start(const bool leo, const Symbol next) const {
+		Chart chart;
+		chart.leo		= leo;
+		chart.next		= next;
+		chart.predicted = BitSet(symbols.size());
+		chart.lastWaiting.assign(symbols.size(), noItem);
+		chart.sets.emplace_back();
+		add(chart, rules[0].item, 0);
+		close(chart);
+		return chart;
+	}
 
-		R[0] = C(R, Rp[0], 0);
+	bool accepts(const Chart &chart) const {
+		return std::ranges::any_of(chart.sets.back().items, [&](const Item &item) {
+			return item.dotted == rules[0].item + 1 && item.origin == 0;
+		});
+	}
 
+	/// fills the chart for the word, and returns whether the word is in the language
+	bool run(const std::vector<Letter> &word, Chart &chart, const bool leo, const bool filter) const {
+		int	 size = word.size() - expect_eof;
+		auto next = [&](const int i) {
+			if (!filter) return anyToken;
+			const Symbol t = i < size ? symbols.find(word[i]) : none;
+			return t != none && isTerminal(t) ? t : none;
+		};
+
+		chart = start(leo, next(0));
 		if (enable_print) {
 			std::cout << "R[0] = ";
-			print(R[0]);
+			print(chart.sets[0]);
 			std::cout << std::endl;
 		}
 
-		int size = word.size() - expect_eof;
-
 		for (int i = 0; i < size; ++i) {
-			if (enable_print) { std::cout << "i = " << i << std::endl; }
-
-			// R′[i+1] = {(A → β1a • β2, j) | (A → β1 • aβ2, j) ∈ Ri и a = ai+1}
-			for (auto &[A, w, dotPos, j] : R[i]) {
-				auto &β1aβ2 = *w;
-				if (dotPos < (int)β1aβ2.size() && β1aβ2[dotPos] == word[i]) {
-					Rp[i + 1].insert({A, &β1aβ2, dotPos + 1, j});
-				}
-			}
-			if (Rp[i + 1].size() == 0) {
-				std::cout << "failed: " << i << " " << word[i] << std::endl;
-				print(R[i]);
-				std::cout << std::endl;
+			const Symbol t = symbols.find(word[i]);
+			chart.next	   = next(i + 1);
+			if (t == none || !isTerminal(t) || !scan(chart, t)) {
+				if (enable_print) std::cout << "failed: " << i << " " << word[i] << std::endl;
+				return false;
 			}
-
-			// Ri+1 = Cε( R, R[i+1], i + 1)
-			R[i + 1] = C(R, Rp[i + 1], i + 1);
+			close(chart);
 
 			if (enable_print) {
-				std::cout << "R'[" << i + 1 << "] = ";
-				print(Rp[i + 1]);
-				std::cout << std::endl;
 				std::cout << "R[" << i + 1 << "] = ";
-				print(R[i + 1]);
+				print(chart.sets[i + 1]);
 				std::cout << std::endl;
 			}
 		}
+		return accepts(chart);
+	}
+
+   public:
+	bool expect_eof	  = false;
+	bool enable_print = false;
+	bool leo		  = true;	  // Leo's optimization for right recursion in recognize
+	bool lookahead	  = false;	  // filter predictions by the next token, except in the online recognizer
+
+	EarleyParser(const CFG<Letter> &g) : grammar(g) {
+		// every letter on a right side that is not a non-terminal is read as a terminal
+		std::vector<Letter> alphabet(g.terminals.begin(), g.terminals.end());
+		for (const auto &[A, v] : g.rules) {
+			for (const auto l : v) {
+				if (!g.nonTerminals.contains(l) && !g.terminals.contains(l)) alphabet.push_back(l);
+			}
+		}
+		symbols = SymbolTable<Letter>(alphabet);
+		for (const auto l : g.nonTerminals) {
+			symbols.add(l);
+		}
+		for (const auto &[A, v] : g.rules) {
+			symbols.add(A);
+		}
+
+		symbols.add(g.start);
+		rulesOf.resize(symbols.size());
+		addRule(symbols.size(), {g.start});
+		for (const auto &[A, v] : g.rules) {
+			addRule(symbols.find(A), v.rhs);
+			rulesOf[symbols.find(A)].push_back(rules.size() - 1);
+		}
+
+		const auto nullables = g.findNullables();
+		nullable.assign(symbols.size(), false);
+		for (const auto &[l, isNullable] : nullables) {
+			if (symbols.contains(l)) nullable[symbols.find(l)] = isNullable;
+		}
+
+		// a rule with a non-terminal that derives no word is never part of a parse. Without them every item in the
+		// chart is on the way to a sentence, so a prefix can be finished as long as its set is not empty
+		std::vector<bool> productive(symbols.size());
+		for (Symbol X = 0; X < symbols.size(); ++X) {
+			productive[X] = isTerminal(X);
+		}
+		auto derivesWord = [&](const Rule &rule) {
+			return std::all_of(rhsSymbols.begin() + rule.rhs, rhsSymbols.begin() + rule.rhs + rule.length,
+							   [&](const Symbol X) { return productive[X]; });
+		};
+		for (bool changed = true; changed;) {
+			changed = false;
+			for (std::size_t r = 1; r < rules.size(); ++r) {
+				if (!productive[rules[r].lhs] && derivesWord(rules[r])) productive[rules[r].lhs] = changed = true;
+			}
+		}
+		for (auto &of : rulesOf) {
+			std::erase_if(of, [&](const std::uint32_t r) { return !derivesWord(rules[r]); });
+		}
+
+		const auto			first = g.findFirsts(nullables);
+		std::vector<BitSet> firstOf(symbols.size(), BitSet(symbols.terminalCount()));
+		for (Symbol X = 0; X < symbols.size(); ++X) {
+			if (isTerminal(X)) {
+				firstOf[X].insert(X);
+				continue;
+			}
+			const auto it = first.find(symbols.letter(X));
+			if (it == first.end()) continue;
+			for (const auto l : it->second) {
+				if (symbols.contains(l) && isTerminal(symbols.find(l))) firstOf[X].insert(symbols.find(l));
+			}
+		}
+		// FIRST of every suffix of every right side, from the shortest suffix to the longest
+		itemFirst.assign(dottedRule.size(), BitSet(symbols.terminalCount()));
+		itemNullable.assign(dottedRule.size(), true);
+		for (const auto &rule : rules) {
+			for (std::uint32_t dot = rule.length; dot-- > 0;) {
+				const Symbol		X	 = rhsSymbols[rule.rhs + dot];
+				const std::uint32_t item = rule.item + dot;
+				itemFirst[item]			 = firstOf[X];
+				if (nullable[X]) {
+					itemFirst[item].merge(itemFirst[item + 1]);
+					itemNullable[item] = itemNullable[item + 1];
+				} else {
+					itemNullable[item] = false;
+				}
+			}
+		}
+	}
+
+	bool recognize(const std::vector<Letter> &word) const {
+		Chart chart;
+		return run(word, chart, leo, lookahead);
+	}
+
+	/// the number of items in the chart for the word, up to where it is rejected
+	std::size_t chartSize(const std::vector<Letter> &word) const {
+		Chart chart;
+		run(word, chart, leo, lookahead);
+		std::size_t size = 0;
+		for (const auto &set : chart.sets) {
+			size += set.items.size();
+		}
+		return size;
+	}
+
+	/**
+	 * @brief Parses a word into a forest of all its parse trees, built from the finished chart. Only the nodes that are
+	 * part of some parse tree of the whole word are made. It needs every complete item in the chart, so it does not use
+	 * Leo's optimization.
+	 *
+	 * @return the forest, which is empty if the word is not in the language
+	 */
+	ParseForest<Letter> parseForest(const std::vector<Letter> &word) const {
+		using NodeID = typename ParseForest<Letter>::NodeID;
+		using Packed = typename ParseForest<Letter>::Packed;
+		constexpr NodeID noNode = ParseForest<Letter>::none;
+
+		ParseForest<Letter> forest;
+		Chart				chart;
+		if (!run(word, chart, false, lookahead)) return forest;
+
+		// the complete items by set, left side and origin, and all the items by set, dotted rule and origin
+		std::vector<std::tuple<std::uint32_t, Symbol, std::uint32_t, std::uint32_t>> complete;
+		fl::unordered_set<std::tuple<std::uint32_t, std::uint32_t, std::uint32_t>>	 items;
+		for (std::uint32_t j = 0; j < chart.sets.size(); ++j) {
+			for (const auto &[dotted, origin, _] : chart.sets[j].items) {
+				items.insert({j, dotted, origin});
+				if (afterDot(dotted) == none && dottedRule[dotted] != 0) {
+					complete.push_back({j, rules[dottedRule[dotted]].lhs, origin, dotted});
+				}
+			}
+		}
+		std::ranges::sort(complete);
+
+		// the nodes are made as they are reached from the root, and expanded once each, so that all the packed nodes
+		// of a node are next to each other
+		struct Expand {
+			NodeID		  id;
+			bool		  intermediate;
+			std::uint32_t what;	   // the symbol, or the dotted rule of an intermediate node
+			std::uint32_t start;
+			std::uint32_t end;
+		};
+		std::vector<Expand>																	 work;
+		fl::unordered_map<std::tuple<bool, std::uint32_t, std::uint32_t, std::uint32_t>, NodeID> nodes;
+
+		auto node = [&](bool intermediate, std::uint32_t what, std::uint32_t i, std::uint32_t j) {
+			auto [it, inserted] = nodes.try_emplace({intermediate, what, i, j}, noNode);
+			if (inserted) {
+				const Letter value = intermediate				? symbols.letter(rules[dottedRule[what]].lhs)
+									 : isTerminal(Symbol(what)) ? word[i]
+																: symbols.letter(what);
+				it->second		   = forest.addNode(value, i, j, intermediate);
+				if (intermediate || !isTerminal(Symbol(what))) work.push_back({it->second, intermediate, what, i, j});
+			}
+			return it->second;
+		};
+		auto completeRange = [&](std::uint32_t j, Symbol X, std::uint32_t i) {
+			return std::ranges::subrange(
+				std::ranges::lower_bound(complete, std::tuple{j, X, i, 0u}),
+				std::ranges::lower_bound(complete, std::tuple{j, X, i + 1, 0u}));
+		};
 
-		for (auto &[A, w, dotPos, j] : R[size]) {
-			auto &β = *w;
-			if (dotPos == (int)β.size() && A == grammar.start) return true;
+		const std::uint32_t n = chart.sets.size() - 1;
+		forest.setRoot(node(false, symbols.find(grammar.start), 0, n));
+
+		std::vector<Packed> packed;
+		while (!work.empty()) {
+			const auto [id, intermediate, what, i, j] = work.back();
+			work.pop_back();
+			packed.clear();
+
+			if (!intermediate) {
+				for (const auto &[_, X, origin, dotted] : completeRange(j, what, i)) {
+					const bool empty = rules[dottedRule[dotted]].length == 0;
+					packed.push_back({noNode, empty ? noNode : node(true, dotted, i, j)});
+				}
+			} else {
+				// the last symbol Y derives the word from some k to j, and the rest of the prefix from i to k
+				const std::uint32_t prefix = what - 1;
+				const Symbol		Y	   = afterDot(prefix);
+				auto				split  = [&](std::uint32_t k) {
+					   if (!items.contains({k, prefix, i})) return;
+					   const bool first = prefix == rules[dottedRule[what]].item;
+					   packed.push_back({first ? noNode : node(true, prefix, i, k), node(false, Y, k, j)});
+				};
+				if (isTerminal(Y)) split(j - 1);
+				else {
+					auto from = std::ranges::lower_bound(complete, std::tuple{j, Y, i, 0u});
+					auto to	  = std::ranges::lower_bound(complete, std::tuple{j, Y + 1, 0u, 0u});
+					for (auto it = from; it != to; ++it) {
+						const std::uint32_t k = std::get<2>(*it);
+						if (it == from || std::get<2>(*(it - 1)) != k) split(k);
+					}
+				}
+			}
+			forest.setPacked(id, packed);
 		}
-		return false;
+		return forest;
 	}
 
-	auto &print(const fl::unordered_set<DottedRule> &R, std::ostream &out = std::cout) {
+	/**
+	 * @brief Recognizes a word that arrives one token at a time. After every token it knows whether the word read so
+	 * far can still be finished to a word in the language, and which terminals can come next. The end of the input is
+	 * not pushed, accepted() tells whether the word can end where it is.
+	 *
+	 * Only the sets that items of the last set lead back to through their origins can be used by a completion later
+	 * on, so the others are dropped from time to time and the remaining sets are numbered again.
+	 */
+	class Recognizer {
+		const EarleyParser *parser;
+		Chart				chart;
+		std::size_t			length	  = 0;
+		std::size_t			collected = 1;	  // the number of sets after the last collection
+
+		/// drops the sets that no item can lead back to, and moves the rest to the front of the chart
+		void collect() {
+			auto					  &sets = chart.sets;
+			std::vector<std::uint32_t> index(sets.size(), noItem);
+			index.back() = 0;
+			for (std::size_t j = sets.size(); j-- > 0;) {
+				if (index[j] == noItem) continue;
+				for (const auto &item : sets[j].items) {
+					index[item.origin] = 0;
+				}
+				for (const auto &top : sets[j].transitive) {
+					if (top.origin != noItem) index[top.origin] = 0;
+				}
+			}
+
+			std::uint32_t live = 0;
+			for (std::size_t j = 0; j < sets.size(); ++j) {
+				if (index[j] == noItem) continue;
+				index[j] = live;
+				if (live != j) sets[live] = std::move(sets[j]);
+				++live;
+			}
+			sets.erase(sets.begin() + live, sets.end());
+			for (auto &set : sets) {
+				for (auto &item : set.items) {
+					item.origin = index[item.origin];
+				}
+				for (auto &top : set.transitive) {
+					if (top.origin != noItem) top.origin = index[top.origin];
+				}
+			}
+		}
+
+	   public:
+		explicit Recognizer(const EarleyParser &parser) : parser(&parser), chart(parser.start(parser.leo, anyToken)) {}
+
+		/**
+		 * @brief Reads the next token of the word
+		 *
+		 * @return false if the word can not go on with it, and then the token is not read
+		 */
+		bool push(const Letter l) {
+			const Symbol t = parser->symbols.find(l);
+			if (t == none || !parser->isTerminal(t) || chart.sets.back().firstWaiting(t) == noItem) return false;
+			parser->scan(chart, t);
+			parser->close(chart);
+			++length;
+
+			if (chart.sets.size() >= 2 * collected + 32) {
+				collect();
+				collected = chart.sets.size();
+			}
+			return true;
+		}
+
+		/// whether the tokens read so far make a word in the language
+		bool accepted() const { return parser->accepts(chart); }
+
+		/// the terminals that can come next
+		std::vector<Letter> expected() const {
+			std::vector<Letter> result;
+			for (const auto &[X, _] : chart.sets.back().waiting) {
+				if (parser->isTerminal(X)) result.push_back(parser->symbols.letter(X));
+			}
+			return result;
+		}
+
+		/// the number of tokens read
+		std::size_t size() const { return length; }
+		/// the number of sets of the chart that are kept
+		std::size_t liveSets() const { return chart.sets.size(); }
+	};
+
+	Recognizer recognizer() const { return Recognizer(*this); }
+
+	auto &print(const EarleySet &R, std::ostream &out = std::cout) const {
 		out << "(";
 		int i = 0;
-		for (auto &r : R) {
+		for (auto &r : R.items) {
 			if (i > 0) out << ", ";
 			print(r, out);
 			++i;
@@ -159,16 +588,16 @@ class EarleyParser {
 		return out;
 	}
 
-	auto &print(const DottedRule &r, std::ostream &out = std::cout) {
-		auto &[A, w, dotPos, j] = r;
-		out << "(" << A << " -> ";
-		auto &β = *w;
-		for (int i = 0; i < (int)β.size(); ++i) {
-			if (i == dotPos) out << "•";
-			out << β[i];
+	auto &print(const Item &r, std::ostream &out = std::cout) const {
+		const Rule &rule = rules[dottedRule[r.dotted]];
+		if (dottedRule[r.dotted] == 0) out << "(" << grammar.start << "' -> ";
+		else out << "(" << symbols.letter(rule.lhs) << " -> ";
+		for (std::uint32_t i = 0; i < rule.length; ++i) {
+			if (rule.item + i == r.dotted) out << "•";
+			out << symbols.letter(rhsSymbols[rule.rhs + i]);
 		}
-		if (dotPos == (int)β.size()) out << "•";
-		std::cout << ", " << j << ")";
+		if (r.dotted == rule.item + rule.length) out << "•";
+		out << ", " << r.origin << ")";
 		return out;
 	}
 };
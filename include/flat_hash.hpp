@@ -0,0 +1,587 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#if defined(__SSE2__)
+	#include <emmintrin.h>
+#endif
+
+#include "hashing.hpp"
+
+namespace fl {
+
+namespace swiss {
+using ctrl_t = std::int8_t;
+
+// a control byte is EMPTY, DELETED or holds the low 7 bits of the hash of a full slot
+inline constexpr ctrl_t		 EMPTY	  = -128;
+inline constexpr ctrl_t		 DELETED  = -2;
+inline constexpr ctrl_t		 SENTINEL = -1;
+inline constexpr std::size_t GROUP	  = 16;
+
+/// 16 consecutive control bytes probed at once, the masks have bit i set for the i-th byte
+struct Group {
+#if defined(__SSE2__)
+	__m128i ctrl;
+
+	explicit Group(const ctrl_t *p) : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))) {}
+
+	std::uint32_t match(ctrl_t h2) const { return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl)); }
+	std::uint32_t matchEmpty() const { return match(EMPTY); }
+	std::uint32_t matchEmptyOrDeleted() const {
+		return _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(SENTINEL), ctrl));
+	}
+#else
+	const ctrl_t *ctrl;
+
+	explicit Group(const ctrl_t *p) : ctrl(p) {}
+
+	template <class Pred>
+	std::uint32_t matching(Pred &&pred) const {
+		std::uint32_t mask = 0;
+		for (std::size_t i = 0; i < GROUP; ++i) {
+			mask |= std::uint32_t(pred(ctrl[i])) << i;
+		}
+		return mask;
+	}
+	std::uint32_t match(ctrl_t h2) const {
+		return matching([h2](ctrl_t c) { return c == h2; });
+	}
+	std::uint32_t matchEmpty() const { return match(EMPTY); }
+	std::uint32_t matchEmptyOrDeleted() const {
+		return matching([](ctrl_t c) { return c < SENTINEL; });
+	}
+#endif
+};
+
+/// spreads the bits of a user hash, the identity hashes of letters and states would otherwise all share h2
+inline std::size_t mix(std::size_t h) { return hashCombine(h, GROUP); }
+
+template <class T>
+concept isTransparent = requires { typename T::is_transparent; };
+
+/**
+ * @brief Open addressing hash table in the style of SwissTable. Slots are stored in one flat array next to an array
+ * of control bytes, lookups probe the control bytes of a whole group of slots at once and only compare keys whose
+ * 7-bit hash fragment matches. Insertion and rehashing invalidate iterators and references to elements.
+ *
+ * @tparam KeyOf - KeyOf::get(value) returns the key of a stored value
+ * @tparam Allocator - allocates the slots and the control bytes and constructs the elements, so a
+ * std::pmr::polymorphic_allocator passes its memory resource on to elements that are containers themselves
+ */
+template <class Key, class Value, class KeyOf, class Hash, class KeyEqual, class Allocator>
+class FlatTable {
+	using Traits	 = std::allocator_traits<Allocator>;
+	using CtrlAlloc	 = typename Traits::template rebind_alloc<ctrl_t>;
+	using SlotAlloc	 = typename Traits::template rebind_alloc<Value>;
+	using SlotTraits = std::allocator_traits<SlotAlloc>;
+
+   public:
+	using key_type		  = Key;
+	using value_type	  = Value;
+	using size_type		  = std::size_t;
+	using difference_type = std::ptrdiff_t;
+	using hasher		  = Hash;
+	using key_equal		  = KeyEqual;
+	using allocator_type  = Allocator;
+	using reference		  = value_type &;
+	using const_reference = const value_type &;
+
+	template <bool Const>
+	class Iterator {
+		friend class FlatTable;
+
+		const ctrl_t *ctrl = nullptr;
+		const ctrl_t *last = nullptr;
+		Value		 *slot = nullptr;
+
+		Iterator(const ctrl_t *ctrl, const ctrl_t *last, Value *slot) : ctrl(ctrl), last(last), slot(slot) {}
+
+		void skipFree() {
+			while (ctrl != last && *ctrl < 0) {
+				++ctrl;
+				++slot;
+			}
+		}
+
+	   public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type		= Value;
+		using difference_type	= std::ptrdiff_t;
+		using pointer			= std::conditional_t<Const, const value_type *, value_type *>;
+		using reference			= std::conditional_t<Const, const value_type &, value_type &>;
+
+		Iterator() = default;
+		template <bool C = Const>
+			requires C
+		Iterator(const Iterator<false> &other) : ctrl(other.ctrl), last(other.last), slot(other.slot) {}
+
+		reference operator*() const { return *slot; }
+		pointer	  operator->() const { return slot; }
+
+		Iterator &operator++() {
+			++ctrl;
+			++slot;
+			skipFree();
+			return *this;
+		}
+		Iterator operator++(int) {
+			Iterator old = *this;
+			++*this;
+			return old;
+		}
+
+		bool operator==(const Iterator &other) const { return ctrl == other.ctrl; }
+
+		friend class Iterator<!Const>;
+	};
+
+	using iterator		 = Iterator<false>;
+	using const_iterator = Iterator<true>;
+
+	FlatTable() = default;
+	explicit FlatTable(const allocator_type &alloc) : alloc(alloc) {}
+
+	template <std::input_iterator It, std::sentinel_for<It> End>
+	FlatTable(It first, End last, const allocator_type &alloc = allocator_type()) : alloc(alloc) {
+		insert(first, last);
+	}
+
+	FlatTable(std::initializer_list<value_type> values, const allocator_type &alloc = allocator_type())
+		: alloc(alloc) {
+		insert(values.begin(), values.end());
+	}
+
+	template <std::ranges::input_range R>
+	FlatTable(std::from_range_t, R &&range, const allocator_type &alloc = allocator_type()) : alloc(alloc) {
+		insert(std::ranges::begin(range), std::ranges::end(range));
+	}
+
+	FlatTable(const FlatTable &other) : FlatTable(other, Traits::select_on_container_copy_construction(other.alloc)) {}
+	FlatTable(const FlatTable &other, const allocator_type &alloc) : alloc(alloc), hash(other.hash), eq(other.eq) {
+		copyFrom(other);
+	}
+
+	FlatTable(FlatTable &&other) noexcept : alloc(std::move(other.alloc)), hash(other.hash), eq(other.eq) {
+		steal(other);
+	}
+	FlatTable(FlatTable &&other, const allocator_type &alloc) : alloc(alloc), hash(other.hash), eq(other.eq) {
+		if (this->alloc == other.alloc) steal(other);
+		else moveFrom(other);
+	}
+
+	FlatTable &operator=(const FlatTable &other) {
+		if (this == &other) return *this;
+		if constexpr (Traits::propagate_on_container_copy_assignment::value) {
+			if (alloc != other.alloc) release();
+			alloc = other.alloc;
+		}
+		clear();
+		hash = other.hash;
+		eq	 = other.eq;
+		copyFrom(other);
+		return *this;
+	}
+
+	/// takes the memory of other when the allocators allow it, otherwise moves the elements one by one
+	FlatTable &operator=(FlatTable &&other) noexcept(Traits::propagate_on_container_move_assignment::value ||
+													 Traits::is_always_equal::value) {
+		if (this == &other) return *this;
+		hash = other.hash;
+		eq	 = other.eq;
+		if constexpr (Traits::propagate_on_container_move_assignment::value) {
+			release();
+			alloc = std::move(other.alloc);
+			steal(other);
+		} else if (alloc == other.alloc) {
+			release();
+			steal(other);
+		} else {
+			clear();
+			moveFrom(other);
+			other.clear();
+		}
+		return *this;
+	}
+
+	FlatTable &operator=(std::initializer_list<value_type> values) {
+		clear();
+		insert(values.begin(), values.end());
+		return *this;
+	}
+
+	~FlatTable() { release(); }
+
+	/// like the std containers, the allocators must be equal unless they propagate on swap
+	void swap(FlatTable &other) noexcept {
+		if constexpr (Traits::propagate_on_container_swap::value) std::swap(alloc, other.alloc);
+		std::swap(ctrl, other.ctrl);
+		std::swap(slots, other.slots);
+		std::swap(capacity, other.capacity);
+		std::swap(elements, other.elements);
+		std::swap(growthLeft, other.growthLeft);
+		std::swap(hash, other.hash);
+		std::swap(eq, other.eq);
+	}
+
+	allocator_type get_allocator() const { return alloc; }
+
+	iterator begin() {
+		iterator it(ctrl, ctrl + capacity, slots);
+		it.skipFree();
+		return it;
+	}
+	const_iterator begin() const { return const_cast<FlatTable *>(this)->begin(); }
+	const_iterator cbegin() const { return begin(); }
+	iterator	   end() { return iterator(ctrl + capacity, ctrl + capacity, slots + capacity); }
+	const_iterator end() const { return const_cast<FlatTable *>(this)->end(); }
+	const_iterator cend() const { return end(); }
+
+	size_type size() const { return elements; }
+	bool	  empty() const { return elements == 0; }
+
+	hasher	  hash_function() const { return hash; }
+	key_equal key_eq() const { return eq; }
+
+	void clear() {
+		for (size_type i = 0; i < capacity; ++i) {
+			if (ctrl[i] >= 0) destroyAt(i);
+		}
+		if (capacity) std::fill(ctrl, ctrl + capacity + GROUP, EMPTY);
+		elements   = 0;
+		growthLeft = maxLoad(capacity);
+	}
+
+	/// makes room for n elements without rehashing
+	void reserve(size_type n) {
+		if (n > elements + growthLeft) rehash(capacityFor(n));
+	}
+
+	iterator find(const key_type &key) { return iteratorAt(findIndex(key, hashOf(key))); }
+	const_iterator find(const key_type &key) const { return const_cast<FlatTable *>(this)->find(key); }
+	bool		   contains(const key_type &key) const { return findIndex(key, hashOf(key)) != capacity; }
+	size_type	   count(const key_type &key) const { return contains(key); }
+
+	template <class K>
+		requires isTransparent<Hash> && isTransparent<KeyEqual>
+	iterator find(const K &key) {
+		return iteratorAt(findIndex(key, hashOf(key)));
+	}
+	template <class K>
+		requires isTransparent<Hash> && isTransparent<KeyEqual>
+	const_iterator find(const K &key) const {
+		return const_cast<FlatTable *>(this)->find(key);
+	}
+	template <class K>
+		requires isTransparent<Hash> && isTransparent<KeyEqual>
+	bool contains(const K &key) const {
+		return findIndex(key, hashOf(key)) != capacity;
+	}
+
+	std::pair<iterator, bool> insert(const value_type &value) { return emplaceKey(KeyOf::get(value), value); }
+	std::pair<iterator, bool> insert(value_type &&value) {
+		return emplaceKey(KeyOf::get(value), std::move(value));
+	}
+
+	/// the hint is ignored, the position of an element depends only on its hash
+	iterator insert(const_iterator, const value_type &value) { return insert(value).first; }
+	iterator insert(const_iterator, value_type &&value) { return insert(std::move(value)).first; }
+
+	template <std::input_iterator It, std::sentinel_for<It> End>
+	void insert(It first, End last) {
+		if constexpr (std::forward_iterator<It>) reserve(elements + std::ranges::distance(first, last));
+		for (; first != last; ++first) {
+			insert(value_type(*first));
+		}
+	}
+	void insert(std::initializer_list<value_type> values) { insert(values.begin(), values.end()); }
+
+	template <class... Args>
+	std::pair<iterator, bool> emplace(Args &&...args) {
+		value_type value(std::forward<Args>(args)...);
+		return insert(std::move(value));
+	}
+
+	size_type erase(const key_type &key) {
+		size_type i = findIndex(key, hashOf(key));
+		if (i == capacity) return 0;
+		eraseAt(i);
+		return 1;
+	}
+
+	iterator erase(const_iterator pos) {
+		size_type i = pos.slot - slots;
+		eraseAt(i);
+		iterator next(ctrl + i, ctrl + capacity, slots + i);
+		next.skipFree();
+		return next;
+	}
+
+	bool operator==(const FlatTable &other) const
+		requires std::equality_comparable<value_type>
+	{
+		if (size() != other.size()) return false;
+		for (const auto &value : *this) {
+			auto it = other.find(KeyOf::get(value));
+			if (it == other.end() || !(*it == value)) return false;
+		}
+		return true;
+	}
+
+   protected:
+	ctrl_t						   *ctrl	   = nullptr;
+	value_type					   *slots	   = nullptr;
+	size_type						capacity   = 0;		// 0 or a power of two, at least GROUP
+	size_type						elements   = 0;
+	size_type						growthLeft = 0;		// insertions into empty slots left before growing
+	[[no_unique_address]] Allocator alloc;
+	[[no_unique_address]] Hash		hash;
+	[[no_unique_address]] KeyEqual	eq;
+
+	static size_type maxLoad(size_type capacity) { return capacity - capacity / 8; }
+	static size_type capacityFor(size_type n) {
+		return std::max(GROUP, std::bit_ceil(n + n / 7 + 1));
+	}
+
+	template <class... Args>
+	void constructAt(size_type i, Args &&...args) {
+		SlotAlloc slotAlloc(alloc);
+		SlotTraits::construct(slotAlloc, slots + i, std::forward<Args>(args)...);
+	}
+
+	void destroyAt(size_type i) {
+		SlotAlloc slotAlloc(alloc);
+		SlotTraits::destroy(slotAlloc, slots + i);
+	}
+
+	/// takes the memory of other, which is left empty
+	void steal(FlatTable &other) {
+		ctrl	   = std::exchange(other.ctrl, nullptr);
+		slots	   = std::exchange(other.slots, nullptr);
+		capacity   = std::exchange(other.capacity, 0);
+		elements   = std::exchange(other.elements, 0);
+		growthLeft = std::exchange(other.growthLeft, 0);
+	}
+
+	void copyFrom(const FlatTable &other) {
+		reserve(other.size());
+		for (const auto &value : other) {
+			insertNew(value, hashOf(KeyOf::get(value)));
+		}
+	}
+
+	void moveFrom(FlatTable &other) {
+		reserve(other.size());
+		for (auto &value : other) {
+			insertNew(std::move(value), hashOf(KeyOf::get(value)));
+		}
+	}
+
+	template <class K>
+	size_type hashOf(const K &key) const {
+		return mix(hash(key));
+	}
+
+	iterator iteratorAt(size_type i) {
+		return i == capacity ? end() : iterator(ctrl + i, ctrl + capacity, slots + i);
+	}
+
+	/// the first GROUP control bytes are mirrored after the last one, so a group can be loaded from any position
+	void setCtrl(size_type i, ctrl_t c) {
+		ctrl[i]										  = c;
+		ctrl[((i - GROUP) & (capacity - 1)) + GROUP] = c;
+	}
+
+	/// index of the slot holding key, or capacity if there is none
+	template <class K>
+	size_type findIndex(const K &key, size_type h) const {
+		if (!capacity) return capacity;
+		const size_type mask = capacity - 1;
+		const ctrl_t	h2	 = h & 0x7F;
+		size_type		pos	 = (h >> 7) & mask;
+		for (size_type step = GROUP;; step += GROUP) {
+			Group g(ctrl + pos);
+			for (std::uint32_t m = g.match(h2); m; m &= m - 1) {
+				size_type i = (pos + std::countr_zero(m)) & mask;
+				if (eq(KeyOf::get(slots[i]), key)) return i;
+			}
+			if (g.matchEmpty()) return capacity;
+			pos = (pos + step) & mask;
+		}
+	}
+
+	/// index of the first empty or deleted slot on the probe sequence of h
+	size_type findFree(size_type h) const {
+		const size_type mask = capacity - 1;
+		size_type		pos	 = (h >> 7) & mask;
+		for (size_type step = GROUP;; step += GROUP) {
+			if (std::uint32_t m = Group(ctrl + pos).matchEmptyOrDeleted()) return (pos + std::countr_zero(m)) & mask;
+			pos = (pos + step) & mask;
+		}
+	}
+
+	/// inserts a value whose key is not in the table yet
+	template <class V>
+	size_type insertNew(V &&value, size_type h) {
+		if (growthLeft == 0) grow();
+		size_type i = findFree(h);
+		if (ctrl[i] == EMPTY) --growthLeft;
+		constructAt(i, std::forward<V>(value));
+		setCtrl(i, h & 0x7F);
+		++elements;
+		return i;
+	}
+
+	template <class K, class... Args>
+	std::pair<iterator, bool> emplaceKey(const K &key, Args &&...args) {
+		size_type h = hashOf(key);
+		size_type i = findIndex(key, h);
+		if (i != capacity) return {iteratorAt(i), false};
+		if (growthLeft == 0) grow();
+		i = findFree(h);
+		if (ctrl[i] == EMPTY) --growthLeft;
+		constructAt(i, std::forward<Args>(args)...);
+		setCtrl(i, h & 0x7F);
+		++elements;
+		return {iteratorAt(i), true};
+	}
+
+	void eraseAt(size_type i) {
+		destroyAt(i);
+		setCtrl(i, DELETED);
+		--elements;
+	}
+
+	/// rehashes into a table twice as large, or of the same size if deleted slots take most of the space
+	void grow() {
+		if (capacity && elements * 2 < maxLoad(capacity)) rehash(capacity);
+		else rehash(capacity ? capacity * 2 : GROUP);
+	}
+
+	void rehash(size_type newCapacity) {
+		ctrl_t		*oldCtrl	 = ctrl;
+		value_type *oldSlots	 = slots;
+		size_type	 oldCapacity = capacity;
+
+		ctrl	 = CtrlAlloc(alloc).allocate(newCapacity + GROUP);
+		slots	 = SlotAlloc(alloc).allocate(newCapacity);
+		capacity = newCapacity;
+		std::fill(ctrl, ctrl + capacity + GROUP, EMPTY);
+		growthLeft = maxLoad(capacity) - elements;
+
+		for (size_type i = 0; i < oldCapacity; ++i) {
+			if (oldCtrl[i] < 0) continue;
+			size_type h = hashOf(KeyOf::get(oldSlots[i]));
+			size_type j = findFree(h);
+			constructAt(j, std::move(oldSlots[i]));
+			setCtrl(j, h & 0x7F);
+			SlotAlloc slotAlloc(alloc);
+			SlotTraits::destroy(slotAlloc, oldSlots + i);
+		}
+		if (oldCapacity) {
+			CtrlAlloc(alloc).deallocate(oldCtrl, oldCapacity + GROUP);
+			SlotAlloc(alloc).deallocate(oldSlots, oldCapacity);
+		}
+	}
+
+	void release() {
+		if (!capacity) return;
+		for (size_type i = 0; i < capacity; ++i) {
+			if (ctrl[i] >= 0) destroyAt(i);
+		}
+		CtrlAlloc(alloc).deallocate(ctrl, capacity + GROUP);
+		SlotAlloc(alloc).deallocate(slots, capacity);
+		ctrl	 = nullptr;
+		slots	 = nullptr;
+		capacity = elements = growthLeft = 0;
+	}
+};
+
+struct SetKey {
+	template <class K>
+	static const K &get(const K &key) {
+		return key;
+	}
+};
+
+struct MapKey {
+	template <class P>
+	static const auto &get(const P &value) {
+		return value.first;
+	}
+};
+}	  // namespace swiss
+
+/// open addressing hash set, see swiss::FlatTable
+template <class K, class Hash = fl::hash<K>, class KeyEqual = std::equal_to<K>, class Allocator = std::allocator<K>>
+class FlatHashSet : public swiss::FlatTable<K, K, swiss::SetKey, Hash, KeyEqual, Allocator> {
+	using Base = swiss::FlatTable<K, K, swiss::SetKey, Hash, KeyEqual, Allocator>;
+
+   public:
+	using Base::Base;
+	using Base::operator=;
+	using iterator = typename Base::const_iterator;
+
+	iterator begin() const { return Base::begin(); }
+	iterator end() const { return Base::end(); }
+
+	iterator find(const K &key) const { return Base::find(key); }
+
+	std::pair<iterator, bool> insert(const K &key) { return Base::insert(key); }
+	std::pair<iterator, bool> insert(K &&key) { return Base::insert(std::move(key)); }
+	using Base::insert;
+};
+
+/// open addressing hash map, see swiss::FlatTable
+template <class K, class V, class Hash = fl::hash<K>, class KeyEqual = std::equal_to<K>,
+		  class Allocator = std::allocator<std::pair<const K, V>>>
+class FlatHashMap : public swiss::FlatTable<K, std::pair<const K, V>, swiss::MapKey, Hash, KeyEqual, Allocator> {
+	using Base = swiss::FlatTable<K, std::pair<const K, V>, swiss::MapKey, Hash, KeyEqual, Allocator>;
+
+   public:
+	using mapped_type = V;
+	using typename Base::iterator;
+	using typename Base::value_type;
+	using Base::Base;
+	using Base::operator=;
+
+	template <class... Args>
+	std::pair<iterator, bool> try_emplace(const K &key, Args &&...args) {
+		return this->emplaceKey(key, std::piecewise_construct, std::forward_as_tuple(key),
+								std::forward_as_tuple(std::forward<Args>(args)...));
+	}
+	template <class... Args>
+	std::pair<iterator, bool> try_emplace(K &&key, Args &&...args) {
+		return this->emplaceKey(key, std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+								std::forward_as_tuple(std::forward<Args>(args)...));
+	}
+
+	template <class M>
+	std::pair<iterator, bool> insert_or_assign(const K &key, M &&value) {
+		auto result = try_emplace(key, std::forward<M>(value));
+		if (!result.second) result.first->second = std::forward<M>(value);
+		return result;
+	}
+
+	V &operator[](const K &key) { return try_emplace(key).first->second; }
+	V &operator[](K &&key) { return try_emplace(std::move(key)).first->second; }
+
+	V &at(const K &key) {
+		auto it = this->find(key);
+		if (it == this->end()) throw std::out_of_range("FlatHashMap::at: key not found");
+		return it->second;
+	}
+	const V &at(const K &key) const { return const_cast<FlatHashMap *>(this)->at(key); }
+};
+
+}	  // namespace fl
@@ -10,6 +10,7 @@
 #include <sstream>
 
 #include "concepts.hpp"
+#include "flat_hash.hpp"
 
 namespace fl {
 
@@ -17,8 +18,8 @@ template <class... Args>
 std::ostream &operator<<(std::ostream &out, const std::tuple<Args...> &t);
 template <class A, class B>
 std::ostream &operator<<(std::ostream &out, const std::pair<A, B> &t);
-template <class T>
-std::ostream &operator<<(std::ostream &out, std::vector<T> v);
+template <class T, class A>
+std::ostream &operator<<(std::ostream &out, const std::vector<T, A> &v);
 
 template <class... Args>
 std::ostream &operator<<(std::ostream &out, const std::tuple<Args...> &t) {
@@ -34,8 +35,8 @@ std::ostream &operator<<(std::ostream &out, const std::pair<A, B> &t) {
 	return out << "(" << t.first << ", " << t.second << ")";
 }
 
-template <class T>
-std::ostream &operator<<(std::ostream &out, std::vector<T> v) {
+template <class T, class A>
+std::ostream &operator<<(std::ostream &out, const std::vector<T, A> &v) {
 	for (const T &x : v)
 		out << x;
 	return out;
@@ -50,6 +51,15 @@ std::ostream &operator<<(std::ostream &out, std::unordered_set<T> v) {
 	return out;
 }
 
+template <class T, class H, class E, class A>
+std::ostream &operator<<(std::ostream &out, const FlatHashSet<T, H, E, A> &v) {
+	out << "( ";
+	for (const T &x : v)
+		out << '\'' << x << "\' ";
+	out << ")";
+	return out;
+}
+
 std::ostream &operator<<(std::ostream &out, const std::exception &e);
 
 template <class A, class B>
@@ -62,6 +72,16 @@ std::ostream &operator<<(std::ostream &out, const std::unordered_map<A, B> &m) {
 	return out;
 }
 
+template <class A, class B, class H, class E, class Alloc>
+std::ostream &operator<<(std::ostream &out, const FlatHashMap<A, B, H, E, Alloc> &m) {
+	out << "{";
+	for (auto &[K, V] : m) {
+		out << '(' << K << " : " << V << ')' << std::endl;
+	}
+	out << "}";
+	return out;
+}
+
 template <typename Char>
 struct basic_ostream_formatter : std::formatter<std::basic_string_view<Char>, Char> {
 	template <typename T, typename OutputIt>
@@ -92,6 +112,8 @@ template <class A, class B>
 struct std::formatter<std::pair<A, B>> : fl::ostream_formatter {};
 template <class T>
 struct std::formatter<std::unordered_set<T>> : fl::ostream_formatter {};
+template <class T, class H, class E, class A>
+struct std::formatter<fl::FlatHashSet<T, H, E, A>> : fl::ostream_formatter {};
 template <class T>
 struct std::formatter<std::vector<T>> : fl::ostream_formatter {};
 template <class A, class B>
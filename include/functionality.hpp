@@ -1,15 +1,21 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <barrier>
 #include <functional>
 #include <iterator>
 #include <ranges>
 #include <string_view>
 #include <unordered_set>
 #include <span>
+#include <thread>
 #include <cassert>
 #include <queue>
+#include <vector>
 #include "TFSA.hpp"
 #include "debug.hpp"
+#include "graph.hpp"
 
 namespace fl {
 
@@ -86,12 +92,134 @@ bool eq(U &&u, V &&v) {
 	return true;
 }
 
+/**
+ * @brief Flat (CSR) view of a real-time TFSA used by the squared-automaton algorithms.
+ * Outgoing and incoming transitions of every state are stored contiguously and sorted by input letter, so the
+ * transitions of the squared automaton from (i, j) are produced by a merge of two sorted runs.
+ * Pairs of states are addressed by the flat index i * N + j.
+ */
+template <class Letter>
+struct RealtimeIndex {
+	using State	   = typename TFSA<Letter>::State;
+	using StringID = typename TFSA<Letter>::StringID;
+
+	struct Edge {
+		Letter	 letter;
+		StringID output;
+		State	 to;	 // the source state for reverse edges
+	};
+
+	unsigned int			  N = 0;
+	std::vector<std::size_t>  offsets;		 // out(q) = edges[offsets[q], offsets[q + 1])
+	std::vector<Edge>		  edges;
+	std::vector<std::size_t>  rOffsets;		 // in(q) = rEdges[rOffsets[q], rOffsets[q + 1])
+	std::vector<Edge>		  rEdges;
+	std::vector<bool>		  finals;
+
+	RealtimeIndex(const TFSA<Letter> &fst) : N(fst.N), offsets(fst.N + 1, 0), rOffsets(fst.N + 1, 0), finals(fst.N) {
+		for (const auto &[from, value] : fst.transitions) {
+			const auto &[_, _, to] = value;
+			++offsets[from + 1];
+			++rOffsets[to + 1];
+		}
+		for (unsigned int q = 0; q < N; ++q) {
+			offsets[q + 1] += offsets[q];
+			rOffsets[q + 1] += rOffsets[q];
+		}
+		edges.resize(offsets[N]);
+		rEdges.resize(rOffsets[N]);
+		std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+		std::vector<std::size_t> rFill(rOffsets.begin(), rOffsets.end() - 1);
+		for (const auto &[from, value] : fst.transitions) {
+			const auto &[l, id, to] = value;
+			edges[fill[from]++]		= {l, id, to};
+			rEdges[rFill[to]++]		= {l, id, from};
+		}
+		auto byLetter = [](const Edge &a, const Edge &b) { return a.letter < b.letter; };
+		for (unsigned int q = 0; q < N; ++q) {
+			std::sort(edges.begin() + offsets[q], edges.begin() + offsets[q + 1], byLetter);
+			std::sort(rEdges.begin() + rOffsets[q], rEdges.begin() + rOffsets[q + 1], byLetter);
+		}
+		for (const auto &q : fst.qFinals) {
+			finals[q] = true;
+		}
+	}
+
+	std::size_t pair(State i, State j) const { return std::size_t(i) * N + j; }
+
+	std::span<const Edge> out(State q) const { return {edges.data() + offsets[q], offsets[q + 1] - offsets[q]}; }
+	std::span<const Edge> in(State q) const { return {rEdges.data() + rOffsets[q], rOffsets[q + 1] - rOffsets[q]}; }
+
+	/// calls f(e1, e2) for every pair of edges from a and b that share the same letter
+	template <class F>
+	static void forEachMatching(std::span<const Edge> a, std::span<const Edge> b, F &&f) {
+		std::size_t i = 0, j = 0;
+		while (i < a.size() && j < b.size()) {
+			if (a[i].letter < b[j].letter) ++i;
+			else if (b[j].letter < a[i].letter) ++j;
+			else {
+				std::size_t iEnd = i, jEnd = j;
+				while (iEnd < a.size() && a[iEnd].letter == a[i].letter)
+					++iEnd;
+				while (jEnd < b.size() && b[jEnd].letter == b[j].letter)
+					++jEnd;
+				for (std::size_t x = i; x < iEnd; ++x)
+					for (std::size_t y = j; y < jEnd; ++y)
+						f(a[x], b[y]);
+				i = iEnd;
+				j = jEnd;
+			}
+		}
+	}
+
+	/// marks every pair (i, j) from which a pair of final states is reachable in the squared automaton
+	std::vector<bool> coAccessiblePairs() const {
+		std::vector<bool>		 coFinals(std::size_t(N) * N, false);
+		std::vector<std::size_t> stack;
+		for (State q = 0; q < N; ++q) {
+			if (!finals[q]) continue;
+			for (State h = 0; h < N; ++h) {
+				if (!finals[h]) continue;
+				coFinals[pair(q, h)] = true;
+				stack.push_back(pair(q, h));
+			}
+		}
+		while (!stack.empty()) {
+			std::size_t Q = stack.back();
+			stack.pop_back();
+			forEachMatching(in(Q / N), in(Q % N), [&](const Edge &t1, const Edge &t2) {
+				std::size_t P = pair(t1.to, t2.to);
+				if (coFinals[P]) return;
+				coFinals[P] = true;
+				stack.push_back(P);
+			});
+		}
+		return coFinals;
+	}
+};
+
+/**
+ * @brief computes the delay (h1, h2) = w(u, v, alpha, beta) into preallocated buffers: the common prefix of
+ * u.alpha and v.beta is removed from both words.
+ */
+template <class Letter, class U, class V, class W, class X>
+auto delayInto(std::vector<Letter> &ua, std::vector<Letter> &vb, U &&u, V &&v, W &&alpha, X &&beta) {
+	ua.assign(std::begin(u), std::end(u));
+	ua.insert(ua.end(), std::begin(alpha), std::end(alpha));
+	vb.assign(std::begin(v), std::end(v));
+	vb.insert(vb.end(), std::begin(beta), std::end(beta));
+	std::size_t k = commonPrefixLen(ua, vb);
+	return std::tuple(std::span<Letter>(ua).subspan(k), std::span<Letter>(vb).subspan(k));
+}
+
 /// expects trimmed real-time FST
 template <class Letter>
 bool isFunctional(const TFSA<Letter> &fst) {
-	// create the squared putput transducer and compute Adm(q) for every state q in it;
+	// create the squared output transducer and compute Adm(q) for every state q in it;
 
-	using State = typename TFSA<Letter>::State;
+	using Index	  = RealtimeIndex<Letter>;
+	using Edge	  = typename Index::Edge;
+	using DelayID = typename UniqueWordSet<Letter>::WordID;
 
 	// check output of empty word
 	int eps_out = -1;
@@ -101,180 +229,91 @@ bool isFunctional(const TFSA<Letter> &fst) {
 		} else if (!std::ranges::equal(fst.words[q], fst.words[eps_out])) return false;
 	}
 
-	unordered_map<std::tuple<State, State>, std::tuple<std::vector<Letter>, std::vector<Letter>>> Adm;
-	std::queue<std::tuple<State, State>>															   queue;
+	const Index				index(fst);
+	const std::vector<bool> coFinals = index.coAccessiblePairs();
+	const std::size_t		N		 = fst.N;
 
-	std::vector<bool> coFinals(fst.N * fst.N, false);
-	{
-		std::vector<std::vector<std::tuple<Letter, State>>> reverseTransitions;
-		reverseTransitions.resize(fst.N);
-		for (const auto &[from, rhs] : fst.transitions) {
-			const auto &[l, _, to] = rhs;
-			reverseTransitions[to].emplace_back(l, from);	  // reverse transitions
-		}
+	dbLog(dbg::LOG_DEBUG, "coFinals: ", std::ranges::count(coFinals, true), " / ", N * N);
 
-		auto DeltaRev = [&reverseTransitions](State i, State j) {
-			return std::views::cartesian_product(reverseTransitions[i], reverseTransitions[j]) |
-				   std::views::filter([](const auto &pair) {
-					   const auto &[t1, t2] = pair;
-					   const auto &[a, _]	= t1;
-					   const auto &[b, _]	= t2;
-					   return a == b;	  // only consider transitions with the same Letter
-				   });
-		};
-
-		std::queue<std::tuple<State, State>> queueRev;
-		for (const auto &q : fst.qFinals) {
-			for (const auto &q2 : fst.qFinals) {
-				queueRev.push({q, q2});
-				coFinals[q * fst.N + q2] = true;	 // mark as co-final
-			}
-		}
-		while (!queueRev.empty()) {
-			auto Q = queueRev.front();
-			queueRev.pop();
-			auto &[q, h] = Q;
-
-			auto Dq = DeltaRev(q, h);
-			for (const auto &[t1, t2] : Dq) {
-				auto &[_, i] = t1;
-				auto &[_, j] = t2;
-				if (coFinals[i * fst.N + j]) continue;
-				coFinals[i * fst.N + j] = true;		// mark as co-final
-				queueRev.push({i, j});
-			}
-		}
-	}
-	int cnt = 0;
-	for (const auto q : coFinals) {
-		if (q) cnt++;
-	}
-	std::cout << "coFinals: " << cnt << " / " << fst.N * fst.N << std::endl;
-
-	auto isCoFinal = [&coFinals, &fst](State i, State j) { return coFinals[i * fst.N + j]; };
-	auto isFinal   = [&fst](State i, State j) { return fst.qFinals.contains(i) && fst.qFinals.contains(j); };
-
-	auto Delta = [&](State i, State j) {
-		auto [b1, e1] = fst.transitions.equal_range(i);
-		auto [b2, e2] = fst.transitions.equal_range(j);
-		auto r1		  = std::ranges::subrange(b1, e1);
-		auto r2		  = std::ranges::subrange(b2, e2);
-		return std::views::cartesian_product(r1, r2) | std::views::filter([&](const auto &pair) {
-				   const auto &[t1, t2]	   = pair;
-				   const auto &[_, value1] = t1;
-				   const auto &[_, value2] = t2;
-				   const auto &[a, _, to1] = value1;
-				   const auto &[b, _, to2] = value2;
-				   return a == b && isCoFinal(to1, to2);	 // only consider transitions with the same letter
-			   });
-	};
+	// Adm(i, j) is a pair of interned delays; only pairs reachable in the squared automaton get an entry
+	UniqueWordSet<Letter>									delays;
+	unordered_map<std::size_t, std::pair<DelayID, DelayID>> Adm;
+	std::queue<std::size_t>									queue;
 
 	for (const auto &q : fst.qFirsts) {
 		for (const auto &q2 : fst.qFirsts) {
-			queue.push({q, q2});
-			Adm.insert({{q, q2}, {{}, {}}});
+			if (Adm.insert({index.pair(q, q2), {0, 0}}).second) queue.push(index.pair(q, q2));
 		}
 	}
-	bool functional = true;
+
+	std::vector<Letter> ua, vb;
+	bool				functional = true;
 	while (!queue.empty() && functional) {
-		auto Q = queue.front();
-		// std::cout << Q << std::endl;
-		auto &[q, h] = Q;
+		std::size_t Q = queue.front();
 		queue.pop();
+		const auto [u, v] = Adm.find(Q)->second;	 // always computed
+
+		Index::forEachMatching(index.out(Q / N), index.out(Q % N), [&](const Edge &t1, const Edge &t2) {
+			if (!functional) return;
+			std::size_t P = index.pair(t1.to, t2.to);
+			if (!coFinals[P]) return;
+
+			auto [h_1, h_2] = delayInto(ua, vb, delays[u], delays[v], fst.words[t1.output], fst.words[t2.output]);
 
-		auto &[u, v] = Adm[Q];	   // always computed
-		// std::cout << "\'" << u << "\',\'" << v << "\'" << std::endl;
-		auto Dq = Delta(q, h);
-		for (const auto &[t1, t2] : Dq) {
-			auto &[_, value1]  = t1;
-			auto &[_, value2]  = t2;
-			auto &[l1, id1, i] = value1;
-			auto &[l2, id2, j] = value2;
-			auto [h_1, h_2]	   = w_noref<Letter>(u, v, fst.words[id1], fst.words[id2]);
-
-			auto q2 = std::tuple(i, j);
 			//  functional(i+1) := ∀(q′, h′) ∈ Dq : (balancible(h′) ∧
 			// ((q′ ∈ F ) → (h′ = (ε, ε))) ∧ (! Adm(i)(q′) → (h′ = Adm(i)(q′))));
 			functional &= balancible(h_1, h_2);
-			functional &= !isFinal(i, j) || (h_1.empty() && h_2.empty());
-			auto q2_it = Adm.find(q2);
-			functional &=
-				q2_it == Adm.end() || (eq(h_1, std::get<0>(q2_it->second)) && eq(h_2, std::get<1>(q2_it->second)));
-
-			if (functional) {
-				if (q2_it == Adm.end()) {
-					queue.push(q2);
-					Adm.insert({{i, j}, {toLetter<Letter>(h_1), toLetter<Letter>(h_2)}});
-				}
-			} else {
-				std::cout << "-> \"" << toString(h_1) << "\", \"" << toString(h_2) << "\"" << std::endl;
-				std::cout << "len: " << h_1.size() << " " << h_2.size() << std::endl;
-				std::cout << "balancible: " << balancible(h_1, h_2) << std::endl;
-				std::cout << "isFinal: " << isFinal(i, j) << std::endl;
-				std::cout << "Q = (" << q << ", " << h << ")" << std::endl;
-				std::cout << "q2 = (" << std::get<0>(q2) << ", " << std::get<1>(q2) << ")" << std::endl;
-				std::cout << "Adm(" << q << ", " << h << ") = (" << toString(u) << "," << toString(v) << ")"
-						  << ", len1: " << u.size() << ", len2: " << v.size() << std::endl;
-				if (q2_it != Adm.end()) {
-					std::cout << "Adm(" << i << ", " << j << ") = (" << toString(std::get<0>(q2_it->second)) << ","
-							  << toString(std::get<1>(q2_it->second)) << ")" << std::endl;
-				} else {
-					std::cout << "Adm(" << i << ", " << j << ") not found" << std::endl;
-				}
-				std::cout << "cofinal(" << i << ", " << j << ") = " << isCoFinal(i, j) << std::endl;
-				std::cout << "l1: " << l1 << ", l2: " << l2 << std::endl;
-				std::cout << "output1: \"" << toString(fst.words[id1]) << "\", output2: \"" << toString(fst.words[id2])
-						  << "\"" << std::endl;
-				std::cout << "length1: " << fst.words[id1].size() << ", length2: " << fst.words[id2].size()
-						  << std::endl;
-
-				return false;	  // not functional
+			functional &= !(index.finals[t1.to] && index.finals[t2.to]) || (h_1.empty() && h_2.empty());
+			auto P_it = Adm.find(P);
+			functional &= P_it == Adm.end() || (std::ranges::equal(h_1, delays[P_it->second.first]) &&
+												std::ranges::equal(h_2, delays[P_it->second.second]));
+
+			if (!functional) {
+				dbLog(dbg::LOG_DEBUG, "not functional: (", Q / N, ", ", Q % N, ") -> (", t1.to, ", ", t2.to,
+					  ") on letter ", t1.letter, " with delay lengths ", h_1.size(), ", ", h_2.size());
+				return;
 			}
-		}
+			if (P_it == Adm.end()) {
+				Adm.insert({P, {delays.addWord(h_1), delays.addWord(h_2)}});
+				queue.push(P);
+			}
+		});
 	}
 
-	return true;
+	return functional;
 }
 
-namespace cmp {
-template <class Letter>
-using State = typename TFSA<Letter>::State;
-template <class Letter>
-using Delay = std::tuple<std::vector<Letter>, std::vector<Letter>>;
-template <class Letter>
-using AdmMap = unordered_set<std::tuple<std::tuple<State<Letter>, State<Letter>>, Delay<Letter>>>;
-template <class Letter>
-using AdmElem = AdmMap<Letter>::value_type;
-
-template <class Letter>
-struct Cmp {
-	using datatype = std::reference_wrapper<const AdmElem<Letter>>;
-	bool operator()(const datatype &a, const datatype &b) const {
-		auto &[q1, delay1] = a.get();
-		auto &[q2, delay2] = b.get();
-		auto &[u1, v1]	   = delay1;
-		auto &[u2, v2]	   = delay2;
-		return u1.size() + v1.size() < u2.size() + v2.size();
-	}
-};
-
-template <class Letter>
-struct Cmp2 {
-	using datatype = std::tuple<State<Letter>, State<Letter>, std::reference_wrapper<const Delay<Letter>>>;
-	bool operator()(const datatype &a, const datatype &b) const {
-		auto &[u1, v1] = std::get<2>(a).get();
-		auto &[u2, v2] = std::get<2>(b).get();
-		return u1.size() + v1.size() < u2.size() + v2.size();
-	}
+/// statistics gathered by testBoundedVariation
+struct BoundedVariationStats {
+	std::size_t maxDelay = 0;	  // length of the longest delay observed in the squared automaton
+	std::size_t explored = 0;	  // number of (pair, delay) configurations expanded
 };
-};	   // namespace cmp
 
-/// expects trimmed real-time FST
+/**
+ * @brief Tests if a trimmed real-time TFSA has bounded variation by exploring the squared automaton together with the
+ * delays of its paths. Fails as soon as a delay exceeds C * |Q|^2, where C is the length of the longest output.
+ *
+ * Delays are interned, so a configuration is a state pair plus two word IDs. After the common prefix is removed, either
+ * one side of a delay is empty, or the two sides start with different letters and can never be reconciled again. The
+ * lengths of such mismatched delays only grow by the lengths of the outputs read, independently of their contents, so
+ * they are kept as lengths only and a mismatched delay is pruned when its lengths are dominated by the maximal lengths
+ * already explored from the same pair.
+ *
+ * The exploration runs in synchronous rounds, sharded across threads by state pair: every shard owns the
+ * configurations of its pairs and receives the successors computed by the other shards between rounds.
+ *
+ * @param fst - trimmed real-time TFSA
+ * @param stats - receives the longest delay observed and the number of configurations explored
+ * @param threads - number of worker threads, the calling thread included. A single one runs no other threads
+ */
 template <class Letter>
-bool testBoundedVariation(const TFSA<Letter> &fst) {
-	// create the squared putput transducer and compute Adm(q) for every state q in it;
+bool testBoundedVariation(const TFSA<Letter> &fst, BoundedVariationStats &stats, unsigned int threads = 1) {
+	using Index	  = RealtimeIndex<Letter>;
+	using Edge	  = typename Index::Edge;
+	using DelayID = typename UniqueWordSet<Letter>::WordID;
 
-	using State = typename TFSA<Letter>::State;
+	stats	= {};
+	threads = std::max(1u, threads);
 
 	// check output of empty word
 	int eps_out = -1;
@@ -284,104 +323,375 @@ bool testBoundedVariation(const TFSA<Letter> &fst) {
 		} else if (!std::ranges::equal(fst.words[q], fst.words[eps_out])) return false;
 	}
 
-	using Delay	 = std::tuple<std::vector<Letter>, std::vector<Letter>>;
-	using AdmMap = unordered_set<std::tuple<std::tuple<State, State>, Delay>>;
-	AdmMap Adm;
-	using AdmElem = AdmMap::value_type;
-
-	std::priority_queue<std::reference_wrapper<const AdmElem>, std::vector<std::reference_wrapper<const AdmElem>>,
-						cmp::Cmp<Letter>>
-		queue;
-
-	std::vector<unsigned int> longestDelay(fst.N * fst.N, 0);
-
-	auto Delta = [&](State i, State j) {
-		auto [b1, e1] = fst.transitions.equal_range(i);
-		auto [b2, e2] = fst.transitions.equal_range(j);
-		auto r1		  = std::ranges::subrange(b1, e1);
-		auto r2		  = std::ranges::subrange(b2, e2);
-		return std::views::cartesian_product(r1, r2) | std::views::filter([&](const auto &pair) {
-				   const auto &[t1, t2]	   = pair;
-				   const auto &[_, value1] = t1;
-				   const auto &[_, value2] = t2;
-				   const auto &[a, _, to1] = value1;
-				   const auto &[b, _, to2] = value2;
-				   return a == b;
-			   });
+	const Index		  index(fst);
+	const std::size_t N = fst.N;
+
+	std::size_t C = 0;
+	for (auto w : fst.words) {
+		C = std::max(C, w.size());
+	}
+	const std::size_t MAX_DELAY = C * N * N;	 // C * |Q|^2
+
+	// a configuration is mismatched iff both lengths are nonzero, then only the lengths are kept
+	struct Config {
+		std::size_t pair;
+		DelayID		u, v;
+		std::size_t lu, lv;
+	};
+	// a successor sent to the shard owning its pair; the nonempty side of a balanced delay is in Outbox::letters
+	struct Message {
+		std::size_t pair;
+		std::size_t lu, lv;
+		std::size_t offset;
+	};
+	struct Outbox {
+		std::vector<Message> messages;
+		std::vector<Letter>	 letters;
+	};
+	struct Shard {
+		UniqueWordSet<Letter>									  delays;
+		unordered_set<std::tuple<std::size_t, DelayID, DelayID>>  seen;		   // balanced configurations
+		unordered_map<std::size_t, std::pair<std::size_t, std::size_t>> mismatch;	   // maximal mismatched lengths
+		std::vector<Config>										  frontier, next;
+		std::vector<Outbox>										  outboxes;	   // indexed by destination shard
+		std::vector<Letter>										  ua, vb;
+		std::size_t												  maxDelay = 0, explored = 0;
 	};
 
-	for (auto &q : fst.qFirsts) {
-		for (auto &q2 : fst.qFirsts) {
-			auto [it, b] = Adm.insert({{q, q2}, {{}, {}}});
-			if (b) [[likely]]
-				queue.emplace(std::ref(*it));
+	auto owner = [threads](std::size_t pair) { return (pair * 0x9E3779B97F4A7C15ull >> 32) % threads; };
+
+	std::vector<Shard> shards(threads);
+	for (auto &shard : shards) {
+		shard.outboxes.resize(threads);
+	}
+	for (const auto &q : fst.qFirsts) {
+		for (const auto &q2 : fst.qFirsts) {
+			std::size_t P	  = index.pair(q, q2);
+			auto	   &shard = shards[owner(P)];
+			if (shard.seen.insert({P, 0, 0}).second) shard.frontier.push_back({P, 0, 0, 0, 0});
 		}
 	}
 
-	unsigned int C = 0;
-	for (auto w : fst.words) {
-		C = std::max<unsigned int>(C, w.size());
+	std::atomic<bool>		 failed	 = false;
+	std::atomic<std::size_t> pending = 0;
+	bool					 done	 = false;
+	unsigned int			 phase	 = 0;
+	// runs once all shards arrive: after an expansion round stop early on failure, after a merge round stop if no
+	// shard has anything left to explore
+	auto onPhase = [&]() noexcept {
+		if (phase++ % 2 == 0) done = failed;
+		else {
+			done	= failed || pending == 0;
+			pending = 0;
+		}
+	};
+	std::barrier sync(threads, onPhase);
+
+	auto expand = [&](Shard &shard) {
+		for (auto &box : shard.outboxes) {
+			box.messages.clear();
+			box.letters.clear();
+		}
+		for (const auto &cfg : shard.frontier) {
+			if (failed) break;
+			++shard.explored;
+			const bool mismatched = cfg.lu && cfg.lv;
+			const auto u		  = shard.delays[cfg.u];
+			const auto v		  = shard.delays[cfg.v];
+			const auto out1		  = index.out(cfg.pair / N);
+			const auto out2		  = index.out(cfg.pair % N);
+
+			Index::forEachMatching(out1, out2, [&](const Edge &t1, const Edge &t2) {
+				if (failed) return;
+				const auto	x = fst.words[t1.output];
+				const auto	y = fst.words[t2.output];
+				std::size_t lu, lv;
+				std::span<Letter> h;
+				if (mismatched) {
+					lu = cfg.lu + x.size();
+					lv = cfg.lv + y.size();
+				} else {
+					auto [h_1, h_2] = delayInto(shard.ua, shard.vb, u, v, x, y);
+					lu				= h_1.size();
+					lv				= h_2.size();
+					h				= lu ? h_1 : h_2;
+				}
+
+				// boundedVariation(i+1) :=
+				// ∀(q′, (u′, v′)) ∈ Dq : ((|u′| ≤ Z) ∧ (|v′| ≤ Z));
+				shard.maxDelay = std::max({shard.maxDelay, lu, lv});
+				if (lu > MAX_DELAY || lv > MAX_DELAY) {
+					failed = true;
+					return;
+				}
+
+				std::size_t P	= index.pair(t1.to, t2.to);
+				auto	   &box = shard.outboxes[owner(P)];
+				box.messages.push_back({P, lu, lv, box.letters.size()});
+				if (!(lu && lv)) box.letters.insert(box.letters.end(), h.begin(), h.end());
+			});
+		}
+		shard.frontier.clear();
+	};
+
+	auto merge = [&](Shard &shard, std::size_t s) {
+		for (const auto &sender : shards) {
+			const auto &box = sender.outboxes[s];
+			for (const auto &[P, lu, lv, offset] : box.messages) {
+				if (lu && lv) {
+					auto &[mu, mv] = shard.mismatch[P];
+					if (lu <= mu && lv <= mv) continue;		// dominated by what was already explored
+					mu = std::max(mu, lu);
+					mv = std::max(mv, lv);
+					shard.next.push_back({P, 0, 0, lu, lv});
+				} else {
+					DelayID id = shard.delays.addWord(std::span{box.letters.data() + offset, lu + lv});
+					DelayID u = lu ? id : 0, v = lv ? id : 0;
+					if (shard.seen.insert({P, u, v}).second) shard.next.push_back({P, u, v, lu, lv});
+				}
+			}
+		}
+		std::swap(shard.frontier, shard.next);
+		pending += shard.frontier.size();
+	};
+
+	auto worker = [&](std::size_t s) {
+		while (true) {
+			expand(shards[s]);
+			sync.arrive_and_wait();
+			if (done) break;
+			merge(shards[s], s);
+			sync.arrive_and_wait();
+			if (done) break;
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (std::size_t s = 1; s < threads; ++s) {
+		workers.emplace_back(worker, s);
+	}
+	worker(0);
+	for (auto &t : workers) {
+		t.join();
 	}
-	auto MAX_DELAY = C * fst.N * fst.N;		// C * |Q|^2
-	auto curr_max  = 0u;
 
-	std::cout << "C = " << C << ", MAX_DELAY = " << MAX_DELAY << std::endl;
+	for (const auto &shard : shards) {
+		stats.maxDelay = std::max(stats.maxDelay, shard.maxDelay);
+		stats.explored += shard.explored;
+	}
+	dbLog(dbg::LOG_DEBUG, "C = ", C, ", MAX_DELAY = ", MAX_DELAY, ", max delay: ", stats.maxDelay,
+		  ", explored: ", stats.explored);
 
-	bool boundedVariation = true;
+	return !failed;
+}
 
-	using namespace std::chrono_literals;
-	SlowDown3 sd(100ms);
-	while (!queue.empty() && boundedVariation) {
-		auto Q = queue.top();
-		// std::cout << Q << std::endl;
-		auto &[q_1, delay] = Q.get();
-		auto &[q, h]	   = q_1;
-		queue.pop();
+/// expects trimmed real-time FST
+template <class Letter>
+bool testBoundedVariation(const TFSA<Letter> &fst) {
+	BoundedVariationStats stats;
+	return testBoundedVariation(fst, stats);
+}
 
-		auto &[u, v] = delay;
-		// std::cout << "\'" << u << "\',\'" << v << "\'" << std::endl;
-		auto Dq = Delta(q, h);
-		for (const auto &[t1, t2] : Dq) {
-			auto &[_, value1] = t1;
-			auto &[_, value2] = t2;
-			auto &[_, id1, i] = value1;
-			auto &[_, id2, j] = value2;
-			auto [h_1, h_2]	  = w_noref<Letter>(u, v, fst.words[id1], fst.words[id2]);
-
-			auto q2 = std::tuple(i, j);
-			// boundedVariation(i+1) :=
-			// ∀(q′, (u′, v′)) ∈ Dq : ((|u′| < Z) ∧ (|v′| < Z));
-			boundedVariation &= h_1.size() < MAX_DELAY && h_2.size() < MAX_DELAY;
-			curr_max = std::max<unsigned int>(curr_max, h_1.size());
-			curr_max = std::max<unsigned int>(curr_max, h_2.size());
-
-			auto &longest = longestDelay[i * fst.N + j];
-			if (longest > h_1.size() && longest > h_2.size()) { continue; }
-
-			longest = std::max<unsigned int>(longest, h_1.size());
-			longest = std::max<unsigned int>(longest, h_2.size());
-
-			sd.do_thing([&]() {
-				std::cout << "\rCurrent max delay: " << curr_max;
-				std::cout << " Adm size: " << Adm.size() << " Delay upper bound: " << MAX_DELAY;
-				std::cout << " queue size: " << queue.size() << std::flush;
-			});
+/// accessible part of the squared automaton of a real-time TFSA together with its strongly connected components
+template <class Letter>
+struct SquaredAutomaton {
+	using Vertex   = CSRGraph::Vertex;
+	using StringID = typename TFSA<Letter>::StringID;
+
+	CSRGraph								   graph;
+	std::vector<std::pair<StringID, StringID>> outputs;	   // the two outputs read on each edge
+	std::vector<std::size_t>				   pairs;	   // index.pair(p, q) of each vertex
+	std::vector<Vertex>						   roots;	   // pairs of initial states
+	SCCs									   sccs;
+
+	SquaredAutomaton(const TFSA<Letter> &fst, const RealtimeIndex<Letter> &index) {
+		using Edge			= typename RealtimeIndex<Letter>::Edge;
+		const std::size_t N = fst.N;
+
+		unordered_map<std::size_t, Vertex> vertices;
+
+		auto vertexOf = [&](std::size_t P) {
+			auto [it, inserted] = vertices.insert({P, pairs.size()});
+			if (inserted) pairs.push_back(P);
+			return it->second;
+		};
+		for (const auto &q : fst.qFirsts) {
+			for (const auto &q2 : fst.qFirsts) {
+				roots.push_back(vertexOf(index.pair(q, q2)));
+			}
+		}
+		for (Vertex v = 0; v < pairs.size(); ++v) {
+			RealtimeIndex<Letter>::forEachMatching(
+				index.out(pairs[v] / N), index.out(pairs[v] % N), [&](const Edge &t1, const Edge &t2) {
+					graph.targets.push_back(vertexOf(index.pair(t1.to, t2.to)));
+					outputs.push_back({t1.output, t2.output});
+				});
+			graph.offsets.push_back(graph.targets.size());
+		}
+		sccs = findSCCs(graph, roots);
+
+		dbLog(dbg::LOG_DEBUG, "squared automaton: ", pairs.size(), " pairs, ", graph.targets.size(), " edges, ",
+			  sccs.count, " components");
+	}
+
+	/// marks the vertices from which a pair of final states is reachable, visiting the components in reverse
+	/// topological order so only the accessible pairs are touched
+	std::vector<bool> coAccessible(const RealtimeIndex<Letter> &index) const {
+		const std::size_t		 N = index.N;
+		std::vector<std::size_t> start(sccs.count + 1, 0);
+		for (Vertex v = 0; v < pairs.size(); ++v) {
+			++start[sccs.component[v] + 1];
+		}
+		for (unsigned int c = 0; c < sccs.count; ++c) {
+			start[c + 1] += start[c];
+		}
+		std::vector<Vertex> members(pairs.size());
+		{
+			std::vector<std::size_t> next(start.begin(), start.end() - 1);
+			for (Vertex v = 0; v < pairs.size(); ++v) {
+				members[next[sccs.component[v]]++] = v;
+			}
+		}
+
+		std::vector<bool> result(pairs.size(), false);
+		for (unsigned int c = 0; c < sccs.count; ++c) {
+			const auto component = std::span(members).subspan(start[c], start[c + 1] - start[c]);
+			bool	   co		 = false;
+			for (Vertex v : component) {
+				co |= index.finals[pairs[v] / N] && index.finals[pairs[v] % N];
+				for (Vertex w : graph.successors(v)) {
+					co |= result[w];
+				}
+			}
+			if (!co) continue;
+			for (Vertex v : component) {
+				result[v] = true;
+			}
+		}
+		return result;
+	}
+};
 
-			if (boundedVariation) {
-				// if (q2_it == Adm.end()) queue.push(q2);
-				auto [inserted_it, b] = Adm.insert({{i, j}, {toLetter<Letter>(h_1), toLetter<Letter>(h_2)}});
-				if (b) [[likely]]
-					queue.emplace(std::ref(*inserted_it));
+/**
+ * @brief Explores the delays between the outputs of the paths in the squared automaton. Delays only change on the
+ * paths between strongly connected components: when a delay first reaches a vertex of a nontrivial component it is
+ * propagated once over the whole component and every edge inside it has to reproduce it.
+ *
+ * @param visit - called as visit(v, u, w) for every new configuration of vertex v with delay (u, w), returning false
+ * stops the search
+ * @param allowed - if not empty, only these vertices are explored, it has to be closed under predecessors
+ * @return the vertex whose loop changed a delay, or SCCs::NONE if every loop keeps its delays or the search was stopped
+ */
+template <class Letter, class Visit>
+CSRGraph::Vertex propagateDelays(const TFSA<Letter> &fst, const SquaredAutomaton<Letter> &sq,
+								 UniqueWordSet<Letter> &delays, const std::vector<bool> &allowed, Visit &&visit) {
+	using Vertex  = CSRGraph::Vertex;
+	using DelayID = typename UniqueWordSet<Letter>::WordID;
+	using Delay	  = std::pair<DelayID, DelayID>;
+
+	const auto &graph = sq.graph;
+	const auto &sccs  = sq.sccs;
+
+	// configurations that were queued, mapped to whether they were already covered by propagating another one
+	unordered_map<std::tuple<Vertex, DelayID, DelayID>, bool> seen;
+	std::queue<std::tuple<Vertex, DelayID, DelayID>>		  queue;
+	std::vector<Letter>										  ua, vb;
+	bool													  stopped = false;
+
+	auto advance = [&](const Delay &d, std::size_t e) -> Delay {
+		const auto &[x, y] = sq.outputs[e];
+		auto [h_1, h_2]	   = delayInto(ua, vb, delays[d.first], delays[d.second], fst.words[x], fst.words[y]);
+		return {delays.addWord(h_1), delays.addWord(h_2)};
+	};
+	auto push = [&](Vertex v, const Delay &d) {
+		if (!allowed.empty() && !allowed[v]) return;
+		if (!seen.insert({{v, d.first, d.second}, false}).second) return;
+		queue.push({v, d.first, d.second});
+		stopped |= !visit(v, d.first, d.second);
+	};
+
+	// delays propagated over the current component, valid where stamp matches the current round
+	std::vector<Delay>		 value(sq.pairs.size());
+	std::vector<std::size_t> stamp(sq.pairs.size(), 0);
+	std::vector<Vertex>		 component;
+	std::size_t				 round = 0;
 
-			} else return false;
+	for (Vertex r : sq.roots) {
+		push(r, {0, 0});
+	}
+	while (!queue.empty() && !stopped) {
+		auto [s, u, v] = queue.front();
+		queue.pop();
+		const unsigned int c = sccs.component[s];
+
+		if (!sccs.nontrivial[c]) {
+			for (std::size_t e = graph.offsets[s]; e < graph.offsets[s + 1] && !stopped; ++e) {
+				push(graph.targets[e], advance({u, v}, e));
+			}
+			continue;
+		}
+
+		bool &covered = seen[{s, u, v}];
+		if (covered) continue;
+		covered = true;
+
+		++round;
+		value[s] = {u, v};
+		stamp[s] = round;
+		component.assign(1, s);
+		for (std::size_t i = 0; i < component.size() && !stopped; ++i) {
+			const Vertex t = component[i];
+			for (std::size_t e = graph.offsets[t]; e < graph.offsets[t + 1] && !stopped; ++e) {
+				const Vertex w = graph.targets[e];
+				const Delay	 d = advance(value[t], e);
+				if (sccs.component[w] != c) {
+					push(w, d);
+				} else if (stamp[w] != round) {
+					value[w] = d;
+					stamp[w] = round;
+					auto [it, inserted] = seen.insert({{w, d.first, d.second}, true});
+					if (inserted) stopped |= !visit(w, d.first, d.second);
+					else it->second = true;
+					component.push_back(w);
+				} else if (value[w] != d) {
+					return w;
+				}
+			}
 		}
 	}
 
-	std::cout << "\rCurrent max delay: " << curr_max;
-	std::cout << " Adm size: " << Adm.size() << " Delay upper bound: " << MAX_DELAY;
-	std::cout << " queue size: " << queue.size() << std::flush;
-	std::cout << "\n\n" << std::flush;
+	return SCCs::NONE;
+}
 
+/**
+ * @brief Tests the twins property of a trimmed real-time TFSA: for every pair of states (p, q) reachable with the same
+ * input and every input loop around both p and q, the delay between the outputs of the two paths must not be changed
+ * by the loop. A functional TFSA can be turned into a subsequential one iff it has the twins property.
+ *
+ * Runs in O((|Q|^2 + |E|^2) * D), where D is the number of different delays entering a strongly connected component
+ * of the squared automaton, instead of exploring delays up to the C * |Q|^2 bound of testBoundedVariation. The first
+ * loop that changes a delay stops the search.
+ *
+ * @param fst - trimmed real-time TFSA
+ */
+template <class Letter>
+bool testTwinsProperty(const TFSA<Letter> &fst) {
+	const RealtimeIndex<Letter>	   index(fst);
+	const SquaredAutomaton<Letter> sq(fst, index);
+	UniqueWordSet<Letter>		   delays;
+
+	auto changed = propagateDelays(fst, sq, delays, {}, [](auto &&...) { return true; });
+	if (changed != SCCs::NONE) {
+		dbLog(dbg::LOG_DEBUG, "twins property fails: a loop through (", sq.pairs[changed] / fst.N, ", ",
+			  sq.pairs[changed] % fst.N, ") changes a delay");
+		return false;
+	}
 	return true;
 }
+
+/// expects trimmed real-time FST, tells if the SSFT constructor will succeed on it
+template <class Letter>
+bool isDeterminizable(const TFSA<Letter> &fst) {
+	return isFunctional(fst) && testTwinsProperty(fst);
+}
 }	  // namespace fl
@@ -0,0 +1,595 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <ranges>
+#include <vector>
+
+#include "cfg.h"
+#include "concepts.hpp"
+#include "datastructures.hpp"
+
+namespace fl {
+
+/**
+ * @brief Rewrites of a CFG that keep its language and bring more grammars within reach of the LL(1) Parser, or into the
+ * Chomsky normal form that the CYK recognizer needs. The new non-terminals they need come from a fresh(base) callback,
+ * which must return a letter the grammar does not use yet; for letters with a createDependentToken (e.g. Token) it can
+ * be left out.
+ */
+namespace transforms {
+
+template <isLetter Letter>
+using Productions = fl::unordered_map<Letter, std::vector<Production<Letter>>>;
+
+/// the productions of every non-terminal, in the order the grammar holds them
+template <isLetter Letter>
+Productions<Letter> productionsOf(const CFG<Letter> &g) {
+	Productions<Letter> result;
+	for (const auto A : g.nonTerminals) {
+		result[A];
+	}
+	for (const auto &[A, v] : g.rules) {
+		result[A].push_back(v);
+	}
+	return result;
+}
+
+/// a grammar with the symbols and AST data of g, but the given productions
+template <isLetter Letter>
+CFG<Letter> withProductions(const CFG<Letter> &g, const std::vector<Letter> &order,
+							const Productions<Letter> &productions) {
+	CFG<Letter> result = g;
+	result.rules	   = {};
+	for (const auto A : order) {
+		for (const auto &v : productions.find(A)->second) {
+			result.addRule(A, v);
+		}
+	}
+	return result;
+}
+
+/// the non-terminals that the start symbol derives sentential forms with
+template <isLetter Letter>
+fl::unordered_set<Letter> reachable(const Letter start, const Productions<Letter> &productions) {
+	fl::unordered_set<Letter> result = {start};
+	std::vector<Letter>		  work	 = {start};
+	while (!work.empty()) {
+		const Letter A = work.back();
+		work.pop_back();
+		for (const auto &v : productions.find(A)->second) {
+			for (const auto X : v) {
+				if (productions.contains(X) && result.insert(X).second) work.push_back(X);
+			}
+		}
+	}
+	return result;
+}
+
+/// the ignore bits of a production, one for every symbol on its right side
+template <isLetter Letter>
+std::vector<bool> ignoreBits(const Production<Letter> &v) {
+	std::vector<bool> result(v.size(), false);
+	std::copy_n(v.ignore.begin(), std::min(v.ignore.size(), v.size()), result.begin());
+	return result;
+}
+
+/// a production made of the symbols [from, to) of v, followed by the letters in tail, which are not ignored
+template <isLetter Letter>
+Production<Letter> slice(const Production<Letter> &v, std::size_t from, std::size_t to, std::vector<Letter> tail,
+						 Letter replaceWith) {
+	const auto			ignore = ignoreBits(v);
+	std::vector<Letter> rhs(v.rhs.begin() + from, v.rhs.begin() + to);
+	std::vector<bool>	bits(ignore.begin() + from, ignore.begin() + to);
+	rhs.insert(rhs.end(), tail.begin(), tail.end());
+	bits.resize(rhs.size(), false);
+	return Production<Letter>(std::move(rhs), bits, replaceWith);
+}
+
+/// the production d followed by the symbols of v after the first one, with the replaceWith of v
+template <isLetter Letter>
+Production<Letter> substitute(const Production<Letter> &d, const Production<Letter> &v) {
+	const auto			tail = ignoreBits(v);
+	std::vector<Letter> rhs	 = d.rhs;
+	std::vector<bool>	bits = ignoreBits(d);
+	rhs.insert(rhs.end(), v.rhs.begin() + 1, v.rhs.end());
+	bits.insert(bits.end(), tail.begin() + 1, tail.end());
+	return Production<Letter>(std::move(rhs), bits, v.replaceWith);
+}
+
+template <isLetter Letter>
+bool sameProduction(const Production<Letter> &a, const Production<Letter> &b) {
+	return a.rhs == b.rhs && ignoreBits(a) == ignoreBits(b) && a.replaceWith == b.replaceWith;
+}
+
+/// adds v to the productions in vs, unless it is there already
+template <isLetter Letter>
+void addProduction(std::vector<Production<Letter>> &vs, Production<Letter> &&v) {
+	if (std::ranges::none_of(vs, [&](const auto &w) { return sameProduction(w, v); })) vs.push_back(std::move(v));
+}
+
+/// a grammar with exactly the non-terminals in order and their productions, and the AST data of g for the old ones
+template <isLetter Letter>
+CFG<Letter> rebuild(const CFG<Letter> &g, const std::vector<Letter> &order, const Productions<Letter> &productions,
+					const Letter start) {
+	auto result	 = withProductions(g, order, productions);
+	result.start = start;
+	for (const auto A : g.nonTerminals) {
+		if (A == start || std::ranges::find(order, A) != order.end()) continue;
+		result.nonTerminals.erase(A);
+		result.nonTerminalData.erase(A);
+	}
+	for (const auto A : order) {
+		result.nonTerminals.insert(A);
+		result.getNonTerminalData(A);
+	}
+	return result;
+}
+
+template <isLetter Letter>
+auto defaultFresh() {
+	return [](const Letter base) { return Letter::createDependentToken(base); };
+}
+
+template <class Letter>
+concept hasDependentLetters = requires(const Letter l) {
+	{ Letter::createDependentToken(l) } -> std::convertible_to<Letter>;
+};
+
+}	  // namespace transforms
+
+/**
+ * @brief Removes left recursion, direct (A -> A a) and through other non-terminals (A -> B a, B -> A b), with Paull's
+ * algorithm. A -> A a_i | b_j becomes A -> b_j A', A' -> a_i A' | eps, which is the grammar that Seq and RepeatChoice
+ * from grammar_factory.hpp build by hand: A' keeps the ignore bits and replaceWith of the rules A -> A a_i, so a chain
+ * of operators gets the same AST as in a hand written LL(1) grammar. To break a cycle through other non-terminals,
+ * their productions are substituted into the first symbol of a rule, and the nodes for them are gone from the tree.
+ * Left recursion hidden behind a nullable prefix (A -> B A with B nullable) is not removed.
+ *
+ * @param g - a grammar without rules of the form A -> A
+ * @param fresh - makes a new non-terminal from an existing one
+ * @return a grammar without left recursion for the same language
+ */
+template <isLetter Letter, class Fresh>
+CFG<Letter> eliminateLeftRecursion(const CFG<Letter> &g, Fresh &&fresh) {
+	using namespace transforms;
+	auto				productions = productionsOf(g);
+	std::vector<Letter> order(g.nonTerminals.begin(), g.nonTerminals.end());
+
+	// a cycle is broken at its non-terminal that is closest to the start, through which the rest of the grammar enters
+	// it, so the others are handled first and the productions substituted for them are left unused
+	fl::unordered_map<Letter, std::size_t> depth = {{g.start, 0}};
+	std::vector<Letter>					   queue = {g.start};
+	for (std::size_t i = 0; i < queue.size(); ++i) {
+		for (const auto &v : productions[queue[i]]) {
+			for (const auto X : v) {
+				if (productions.contains(X) && depth.insert({X, depth[queue[i]] + 1}).second) queue.push_back(X);
+			}
+		}
+	}
+	std::ranges::stable_sort(order, std::greater{}, [&](const Letter A) {
+		auto it = depth.find(A);
+		return it == depth.end() ? SIZE_MAX : it->second;
+	});
+	const auto usedBefore = reachable(g.start, productions);
+
+	// only the non-terminals that start a cycle of left corners need to be rewritten, so find them first
+	fl::unordered_map<Letter, std::vector<Letter>> leftCorners;
+	for (const auto &[A, vs] : productions) {
+		for (const auto &v : vs) {
+			if (!v.empty() && g.nonTerminals.contains(v[0])) leftCorners[A].push_back(v[0]);
+		}
+	}
+	auto reaches = [&](const Letter from, const Letter to) {
+		fl::unordered_set<Letter> seen;
+		std::vector<Letter>		  work = {from};
+		while (!work.empty()) {
+			const Letter X = work.back();
+			work.pop_back();
+			for (const auto Y : leftCorners[X]) {
+				if (Y == to) return true;
+				if (seen.insert(Y).second) work.push_back(Y);
+			}
+		}
+		return false;
+	};
+	fl::unordered_set<Letter> recursive;
+	for (const auto A : order) {
+		if (reaches(A, A)) recursive.insert(A);
+	}
+
+	std::vector<Letter> result = order;
+	for (std::size_t i = 0; i < order.size(); ++i) {
+		const Letter A = order[i];
+		if (!recursive.contains(A)) continue;
+
+		// A -> B c, where B comes earlier and has no left recursion any more, becomes A -> d c for every B -> d
+		for (std::size_t j = 0; j < i; ++j) {
+			const Letter B = order[j];
+			if (!recursive.contains(B) || !reaches(B, A)) continue;
+			std::vector<Production<Letter>> rewritten;
+			for (const auto &v : productions[A]) {
+				if (v.empty() || v[0] != B) {
+					rewritten.push_back(v);
+					continue;
+				}
+				for (const auto &d : productions[B]) {
+					rewritten.push_back(substitute(d, v));
+				}
+			}
+			productions[A] = std::move(rewritten);
+		}
+
+		std::vector<Production<Letter>> recursions, others;
+		for (const auto &v : productions[A]) {
+			if (!v.empty() && v[0] == A) {
+				if (v.size() > 1) recursions.push_back(v);
+			} else {
+				others.push_back(v);
+			}
+		}
+		if (recursions.empty()) continue;
+
+		const Letter tail = fresh(A);
+		productions[A].clear();
+		for (const auto &v : others) {
+			productions[A].push_back(slice(v, 0, v.size(), {tail}, v.replaceWith));
+		}
+		auto &tailProductions = productions[tail];
+		for (const auto &v : recursions) {
+			tailProductions.push_back(slice(v, 1, v.size(), {tail}, v.replaceWith));
+		}
+		tailProductions.push_back(Production<Letter>(std::vector<Letter>{}));
+		result.push_back(tail);
+	}
+
+	const auto usedAfter = reachable(g.start, productions);
+	std::erase_if(result, [&](const Letter A) { return usedBefore.contains(A) && !usedAfter.contains(A); });
+
+	auto transformed = withProductions(g, result, productions);
+	for (const auto A : usedBefore) {
+		if (usedAfter.contains(A)) continue;
+		transformed.nonTerminals.erase(A);
+		transformed.nonTerminalData.erase(A);
+	}
+	for (const auto A : result | std::views::filter([&](const Letter A) { return !g.nonTerminals.contains(A); })) {
+		transformed.getNonTerminalData(A) = {};
+	}
+	return transformed;
+}
+
+template <isLetter Letter>
+	requires transforms::hasDependentLetters<Letter>
+CFG<Letter> eliminateLeftRecursion(const CFG<Letter> &g) {
+	return eliminateLeftRecursion(g, transforms::defaultFresh<Letter>());
+}
+
+/**
+ * @brief Left-factors the productions of every non-terminal: A -> a b_1 | a b_2 becomes A -> a A', A' -> b_1 | b_2,
+ * repeatedly, until no two productions of a non-terminal start with the same symbol. A' always spills its children into
+ * A, and A -> a A' keeps the replaceWith of the old productions, so the AST does not change. Productions that would
+ * need different replaceWith letters or ignore bits in the common prefix are left as they are.
+ *
+ * When two productions start with different symbols, but can start with the same terminal, the non-terminal that one of
+ * them starts with is inlined into it, so that they can be factored. Its node is gone from the AST then.
+ *
+ * @param g - a grammar without left recursion
+ * @param fresh - makes a new non-terminal from an existing one
+ * @return a left-factored grammar for the same language
+ */
+template <isLetter Letter, class Fresh>
+CFG<Letter> leftFactor(const CFG<Letter> &g, Fresh &&fresh) {
+	using namespace transforms;
+	auto				productions = productionsOf(g);
+	std::vector<Letter> order(g.nonTerminals.begin(), g.nonTerminals.end());
+	std::vector<Letter> helpers;
+
+	// the FIRST sets of the non-terminals do not change when their productions are factored or inlined, only the new
+	// ones need theirs
+	auto nullable = g.findNullables();
+	auto first	  = g.findFirsts(nullable);
+	auto overlap  = [&](const Production<Letter> &a, const Production<Letter> &b) {
+		 const auto firstB = g.first(b.rhs, nullable, first);
+		 const auto firstA = g.first(a.rhs, nullable, first);
+		 return std::ranges::any_of(firstA, [&](const Letter l) { return firstB.contains(l); });
+	};
+	auto group = [](const Production<Letter> &v) { return std::pair(v[0], ignoreBits(v)[0]); };
+
+	constexpr std::size_t maxInlines = 64;
+	for (std::size_t i = 0; i < order.size(); ++i) {
+		const Letter A		 = order[i];
+		std::size_t	 inlines = 0;
+
+		for (bool changed = true; changed;) {
+			changed		  = false;
+			const auto vs = productions[A];
+			for (std::size_t k = 0; k < vs.size() && !changed; ++k) {
+				if (vs[k].empty()) continue;
+
+				std::vector<std::size_t> members;
+				for (std::size_t m = 0; m < vs.size(); ++m) {
+					if (!vs[m].empty() && group(vs[m]) == group(vs[k]) && vs[m].replaceWith == vs[k].replaceWith) {
+						members.push_back(m);
+					}
+				}
+				if (members.size() < 2) continue;
+
+				// the longest prefix, with its ignore bits, that all the productions in the group share
+				std::size_t prefix = vs[k].size();
+				for (const auto m : members) {
+					const auto	a = ignoreBits(vs[k]), b = ignoreBits(vs[m]);
+					std::size_t l = 0;
+					while (l < std::min(prefix, vs[m].size()) && vs[m][l] == vs[k][l] && a[l] == b[l]) {
+						++l;
+					}
+					prefix = l;
+				}
+
+				const Letter					tail = fresh(A);
+				std::vector<Production<Letter>> rest, tailProductions;
+				for (std::size_t m = 0; m < vs.size(); ++m) {
+					if (std::ranges::find(members, m) == members.end()) {
+						rest.push_back(vs[m]);
+						continue;
+					}
+					auto suffix = slice(vs[m], prefix, vs[m].size(), {}, Letter::eps);
+					auto same = [&](const auto &w) { return sameProduction(w, suffix); };
+					if (std::ranges::none_of(tailProductions, same)) {
+						tailProductions.push_back(std::move(suffix));
+					}
+				}
+				rest.push_back(slice(vs[k], 0, prefix, {tail}, vs[k].replaceWith));
+
+				fl::unordered_set<Letter> tailFirst;
+				bool					  tailNullable = false;
+				for (const auto &v : tailProductions) {
+					const auto firstV = g.first(v.rhs, nullable, first);
+					tailFirst.insert(firstV.begin(), firstV.end());
+					tailNullable = tailNullable || g.nullable(v.rhs, nullable);
+				}
+				first[tail]	   = std::move(tailFirst);
+				nullable[tail] = tailNullable;
+
+				productions[A]	  = std::move(rest);
+				productions[tail] = std::move(tailProductions);
+				order.push_back(tail);
+				helpers.push_back(tail);
+				changed = true;
+			}
+
+			for (std::size_t k = 0; k < vs.size() && !changed && inlines < maxInlines; ++k) {
+				for (std::size_t m = 0; m < vs.size() && !changed; ++m) {
+					const auto &v = vs[k];
+					if (m == k || v.empty() || v[0] == A || !productions.contains(v[0]) || !overlap(v, vs[m])) continue;
+					std::vector<Production<Letter>> rewritten;
+					for (std::size_t n = 0; n < vs.size(); ++n) {
+						if (n != k) rewritten.push_back(vs[n]);
+					}
+					for (const auto &d : productions[v[0]]) {
+						rewritten.push_back(substitute(d, v));
+					}
+					productions[A] = std::move(rewritten);
+					++inlines;
+					changed = true;
+				}
+			}
+		}
+	}
+
+	auto transformed = withProductions(g, order, productions);
+	for (const auto A : helpers) {
+		transformed.getNonTerminalData(A) = {.upwardSpillThreshold = INT_MAX, .ignoreEmpty = true,
+											 .ignoreSingleChild = false};
+	}
+	return transformed;
+}
+
+template <isLetter Letter>
+	requires transforms::hasDependentLetters<Letter>
+CFG<Letter> leftFactor(const CFG<Letter> &g) {
+	return leftFactor(g, transforms::defaultFresh<Letter>());
+}
+
+/**
+ * @brief Removes left recursion, then left-factors, which is what most grammars written for an LR or an Earley parser
+ * need before the LL(1) Parser accepts them
+ */
+template <isLetter Letter, class Fresh>
+CFG<Letter> toLL1Form(const CFG<Letter> &g, Fresh &&fresh) {
+	return leftFactor(eliminateLeftRecursion(g, fresh), fresh);
+}
+
+template <isLetter Letter>
+	requires transforms::hasDependentLetters<Letter>
+CFG<Letter> toLL1Form(const CFG<Letter> &g) {
+	return toLL1Form(g, transforms::defaultFresh<Letter>());
+}
+
+/**
+ * @brief Removes the useless symbols: first the rules with a non-terminal that derives no word, then the non-terminals
+ * that the start symbol does not reach. The start symbol stays even if its language is empty.
+ */
+template <isLetter Letter>
+CFG<Letter> removeUseless(const CFG<Letter> &g) {
+	using namespace transforms;
+	auto productions = productionsOf(g);
+	productions[g.start];
+
+	fl::unordered_set<Letter> productive;
+	auto isProductive = [&](const Letter X) { return !productions.contains(X) || productive.contains(X); };
+	auto derivesWord  = [&](const Production<Letter> &v) { return std::ranges::all_of(v, isProductive); };
+	for (bool changed = true; changed;) {
+		changed = false;
+		for (const auto &[A, vs] : productions) {
+			if (!productive.contains(A) && std::ranges::any_of(vs, derivesWord)) changed = productive.insert(A).second;
+		}
+	}
+	for (auto &[A, vs] : productions) {
+		std::erase_if(vs, [&](const Production<Letter> &v) { return !derivesWord(v); });
+	}
+
+	const auto			used = reachable(g.start, productions);
+	std::vector<Letter> order;
+	for (const auto A : g.nonTerminals) {
+		if (used.contains(A)) order.push_back(A);
+	}
+	if (!g.nonTerminals.contains(g.start)) order.push_back(g.start);
+	return rebuild(g, order, productions, g.start);
+}
+
+/**
+ * @brief Removes the rules A -> eps. Every rule gets a copy without each subset of its nullable symbols, so a rule
+ * with k of them becomes up to 2^k rules. If the start symbol is nullable, it keeps its eps rule, and if it is on a
+ * right side as well, a new start symbol S' -> S | eps takes its place.
+ *
+ * @param fresh - makes a new non-terminal from an existing one
+ */
+template <isLetter Letter, class Fresh>
+CFG<Letter> removeEpsilonRules(const CFG<Letter> &g, Fresh &&fresh) {
+	using namespace transforms;
+	const auto			old		 = productionsOf(g);
+	const auto			nullable = g.findNullables();
+	Productions<Letter> productions;
+	std::vector<Letter> order(g.nonTerminals.begin(), g.nonTerminals.end());
+	auto isNullable = [&](const Letter X) {
+		auto it = nullable.find(X);
+		return it != nullable.end() && it->second;
+	};
+
+	bool startOnRight = false;
+	for (const auto A : order) {
+		auto &vs = productions[A];
+		for (const auto &v : old.find(A)->second) {
+			startOnRight = startOnRight || std::ranges::find(v, g.start) != v.end();
+
+			std::vector<std::size_t> optional;
+			for (std::size_t k = 0; k < v.size(); ++k) {
+				if (isNullable(v[k])) optional.push_back(k);
+			}
+			const auto ignore = ignoreBits(v);
+			for (std::size_t mask = 0; mask < (std::size_t(1) << optional.size()); ++mask) {
+				std::vector<Letter> rhs;
+				std::vector<bool>	bits;
+				for (std::size_t k = 0, o = 0; k < v.size(); ++k) {
+					if (o < optional.size() && optional[o] == k && (mask >> o++ & 1)) continue;
+					rhs.push_back(v[k]);
+					bits.push_back(ignore[k]);
+				}
+				if (rhs.empty() || (rhs.size() == 1 && rhs[0] == A)) continue;
+				addProduction(vs, Production<Letter>(std::move(rhs), bits, v.replaceWith));
+			}
+		}
+	}
+
+	Letter start = g.start;
+	if (isNullable(g.start)) {
+		if (startOnRight) {
+			start			   = fresh(g.start);
+			productions[start] = {Production<Letter>(std::vector<Letter>{g.start})};
+			order.push_back(start);
+		}
+		productions[start].push_back(Production<Letter>(std::vector<Letter>{}));
+	}
+	return rebuild(g, order, productions, start);
+}
+
+template <isLetter Letter>
+	requires transforms::hasDependentLetters<Letter>
+CFG<Letter> removeEpsilonRules(const CFG<Letter> &g) {
+	return removeEpsilonRules(g, transforms::defaultFresh<Letter>());
+}
+
+/**
+ * @brief Removes the rules A -> B, where B is a non-terminal: A gets the other rules of every non-terminal it derives
+ * through a chain of them
+ */
+template <isLetter Letter>
+CFG<Letter> removeUnitRules(const CFG<Letter> &g) {
+	using namespace transforms;
+	const auto			old = productionsOf(g);
+	Productions<Letter> productions;
+	std::vector<Letter> order(g.nonTerminals.begin(), g.nonTerminals.end());
+	auto isUnit = [&](const Production<Letter> &v) { return v.size() == 1 && old.contains(v[0]); };
+
+	for (const auto A : order) {
+		auto				&vs		= productions[A];
+		std::vector<Letter>		  chain = {A};
+		fl::unordered_set<Letter> seen	= {A};
+		for (std::size_t i = 0; i < chain.size(); ++i) {
+			for (const auto &v : old.find(chain[i])->second) {
+				if (!isUnit(v)) addProduction(vs, Production<Letter>(v));
+				else if (seen.insert(v[0]).second) chain.push_back(v[0]);
+			}
+		}
+	}
+	return rebuild(g, order, productions, g.start);
+}
+
+/**
+ * @brief Brings a grammar to Chomsky normal form, where every rule is A -> BC or A -> a, and only the start symbol,
+ * which is on no right side, can have S -> eps. The steps are the usual ones, in an order that keeps the grammar
+ * polynomial: a new start symbol, a non-terminal for every terminal in a longer rule, rules split into rules of two
+ * symbols, then removeEpsilonRules, removeUnitRules and removeUseless. The ignore bits and replaceWith of the rules
+ * do not describe an AST any more, so the result is meant for recognizing.
+ *
+ * @param fresh - makes a new non-terminal from an existing one
+ */
+template <isLetter Letter, class Fresh>
+CFG<Letter> toChomskyNormalForm(const CFG<Letter> &g, Fresh &&fresh) {
+	using namespace transforms;
+	const auto			useful = removeUseless(g);
+	auto				old	   = productionsOf(useful);
+	std::vector<Letter> order(useful.nonTerminals.begin(), useful.nonTerminals.end());
+
+	Letter start = useful.start;
+	auto   onRight = [&](const Production<Letter> &v) { return std::ranges::find(v, useful.start) != v.end(); };
+	if (std::ranges::any_of(old, [&](const auto &entry) { return std::ranges::any_of(entry.second, onRight); })) {
+		start	   = fresh(useful.start);
+		old[start] = {Production<Letter>(std::vector<Letter>{useful.start})};
+		order.push_back(start);
+	}
+
+	Productions<Letter>				  productions;
+	fl::unordered_map<Letter, Letter> terminalOf;
+	const std::size_t				  original = order.size();
+	for (std::size_t i = 0; i < original; ++i) {
+		const Letter A = order[i];
+		productions[A];
+		for (auto rhs : old.find(A)->second | std::views::transform(&Production<Letter>::rhs)) {
+			if (rhs.size() >= 2) {
+				for (auto &X : rhs) {
+					if (old.contains(X)) continue;
+					auto [it, inserted] = terminalOf.try_emplace(X, X);
+					if (inserted) {
+						it->second				= fresh(X);
+						productions[it->second] = {Production<Letter>(std::vector<Letter>{X})};
+						order.push_back(it->second);
+					}
+					X = it->second;
+				}
+			}
+
+			// A -> X_1 X_2 ... X_n becomes A -> X_1 A_1, A_1 -> X_2 A_2, ..., A_n-2 -> X_n-1 X_n
+			Letter lhs = A;
+			while (rhs.size() > 2) {
+				const Letter rest = fresh(A);
+				productions[lhs].push_back(Production<Letter>(std::vector<Letter>{rhs[0], rest}));
+				order.push_back(rest);
+				rhs.erase(rhs.begin());
+				lhs = rest;
+			}
+			productions[lhs].push_back(Production<Letter>(std::move(rhs)));
+		}
+	}
+
+	const auto binary = rebuild(useful, order, productions, start);
+	return removeUseless(removeUnitRules(removeEpsilonRules(binary, fresh)));
+}
+
+template <isLetter Letter>
+	requires transforms::hasDependentLetters<Letter>
+CFG<Letter> toChomskyNormalForm(const CFG<Letter> &g) {
+	return toChomskyNormalForm(g, transforms::defaultFresh<Letter>());
+}
+
+}	  // namespace fl
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace fl {
+
+/// directed graph on the vertices 0..size()-1 stored in compressed sparse row form.
+/// the edges of vertex v are targets[offsets[v]..offsets[v + 1]), edge indices can be used to index data kept
+/// alongside the graph.
+struct CSRGraph {
+	using Vertex = unsigned int;
+
+	std::vector<std::size_t> offsets{0};
+	std::vector<Vertex>		 targets;
+
+	std::size_t size() const { return offsets.size() - 1; }
+
+	std::span<const Vertex> successors(Vertex v) const {
+		return {targets.data() + offsets[v], offsets[v + 1] - offsets[v]};
+	}
+};
+
+/// strongly connected components of a graph
+struct SCCs {
+	static constexpr unsigned int NONE = -1;
+
+	std::vector<unsigned int> component;	 // component of each vertex
+	std::vector<bool>		  nontrivial;	 // component has more than one vertex or a self-loop
+	unsigned int			  count = 0;
+};
+
+/**
+ * @brief Finds the strongly connected components of a graph with an iterative version of Tarjan's algorithm, so it
+ * does not depend on the depth of the call stack. Components are numbered in reverse topological order.
+ *
+ * @param g - the graph
+ * @param roots - vertices to start the search from, the components of vertices not reachable from them are NONE
+ */
+template <class Roots>
+SCCs findSCCs(const CSRGraph &g, Roots &&roots) {
+	using Vertex			   = CSRGraph::Vertex;
+	constexpr Vertex UNVISITED = -1;
+
+	const std::size_t N = g.size();
+	SCCs			  result;
+	result.component.assign(N, SCCs::NONE);
+
+	std::vector<Vertex>							 index(N, UNVISITED), low(N);
+	std::vector<bool>							 onStack(N, false);
+	std::vector<Vertex>							 stack;
+	std::vector<std::pair<Vertex, std::size_t>> calls;	   // vertex and its next edge to visit
+	Vertex										 next = 0;
+
+	auto visit = [&](Vertex v) {
+		index[v] = low[v] = next++;
+		stack.push_back(v);
+		onStack[v] = true;
+		calls.push_back({v, g.offsets[v]});
+	};
+
+	for (Vertex root : roots) {
+		if (index[root] != UNVISITED) continue;
+		visit(root);
+		while (!calls.empty()) {
+			auto &[v, e] = calls.back();
+			if (e < g.offsets[v + 1]) {
+				Vertex w = g.targets[e++];
+				if (index[w] == UNVISITED) visit(w);
+				else if (onStack[w]) low[v] = std::min(low[v], index[w]);
+				continue;
+			}
+
+			Vertex u = v;
+			calls.pop_back();
+			if (!calls.empty()) {
+				Vertex parent = calls.back().first;
+				low[parent]	  = std::min(low[parent], low[u]);
+			}
+			if (low[u] != index[u]) continue;
+
+			std::size_t size = 0;
+			Vertex		w;
+			do {
+				w = stack.back();
+				stack.pop_back();
+				onStack[w]			= false;
+				result.component[w] = result.count;
+				++size;
+			} while (w != u);
+			result.nontrivial.push_back(size > 1);
+			++result.count;
+		}
+	}
+
+	for (Vertex v = 0; v < N; ++v) {
+		if (result.component[v] == SCCs::NONE) continue;
+		for (Vertex w : g.successors(v)) {
+			if (w == v) result.nontrivial[result.component[v]] = true;
+		}
+	}
+	return result;
+}
+
+/// finds the strongly connected components of the whole graph
+inline SCCs findSCCs(const CSRGraph &g) {
+	std::vector<CSRGraph::Vertex> roots(g.size());
+	for (CSRGraph::Vertex v = 0; v < roots.size(); ++v) {
+		roots[v] = v;
+	}
+	return findSCCs(g, roots);
+}
+
+}	  // namespace fl
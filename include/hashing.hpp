@@ -1,13 +1,130 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <span>
 #include <string_view>
+#include <type_traits>
 
 #include "concepts.hpp"
 
 namespace fl {
+
+namespace wy {
+// constants and primitives of wyhash (final version 4) by Wang Yi, released into the public domain
+inline constexpr std::uint64_t secret[4] = {0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull,
+											0x589965cc75374cc3ull};
+
+inline std::uint64_t mix(std::uint64_t a, std::uint64_t b) {
+	__uint128_t r = __uint128_t(a) * b;
+	return std::uint64_t(r) ^ std::uint64_t(r >> 64);
+}
+
+inline std::uint64_t read8(const unsigned char *p) {
+	std::uint64_t v;
+	std::memcpy(&v, p, 8);
+	return v;
+}
+
+inline std::uint64_t read4(const unsigned char *p) {
+	std::uint32_t v;
+	std::memcpy(&v, p, 4);
+	return v;
+}
+
+inline std::uint64_t read3(const unsigned char *p, std::size_t k) {
+	return (std::uint64_t(p[0]) << 16) | (std::uint64_t(p[k >> 1]) << 8) | p[k - 1];
+}
+}	  // namespace wy
+
+/// hashes n bytes of memory with wyhash, which reads 48 bytes per step on three independent lanes
+inline std::size_t hashBytes(const void *data, std::size_t n, std::uint64_t seed = 0) {
+	const auto *p = static_cast<const unsigned char *>(data);
+	seed ^= wy::mix(seed ^ wy::secret[0], wy::secret[1]);
+	std::uint64_t a, b;
+	if (n <= 16) {
+		if (n >= 4) {
+			a = (wy::read4(p) << 32) | wy::read4(p + ((n >> 3) << 2));
+			b = (wy::read4(p + n - 4) << 32) | wy::read4(p + n - 4 - ((n >> 3) << 2));
+		} else if (n > 0) {
+			a = wy::read3(p, n);
+			b = 0;
+		} else a = b = 0;
+	} else {
+		std::size_t i = n;
+		if (i >= 48) {
+			std::uint64_t see1 = seed, see2 = seed;
+			do {
+				seed = wy::mix(wy::read8(p) ^ wy::secret[1], wy::read8(p + 8) ^ seed);
+				see1 = wy::mix(wy::read8(p + 16) ^ wy::secret[2], wy::read8(p + 24) ^ see1);
+				see2 = wy::mix(wy::read8(p + 32) ^ wy::secret[3], wy::read8(p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			} while (i >= 48);
+			seed ^= see1 ^ see2;
+		}
+		while (i > 16) {
+			seed = wy::mix(wy::read8(p) ^ wy::secret[1], wy::read8(p + 8) ^ seed);
+			i -= 16;
+			p += 16;
+		}
+		a = wy::read8(p + i - 16);
+		b = wy::read8(p + i - 8);
+	}
+	a ^= wy::secret[1];
+	b ^= seed;
+	__uint128_t r = __uint128_t(a) * b;
+	a			  = std::uint64_t(r);
+	b			  = std::uint64_t(r >> 64);
+	return wy::mix(a ^ wy::secret[0] ^ n, b ^ wy::secret[1]);
+}
+
+/// mixes the hash h into seed, unlike XOR the result depends on the order of combining
+inline std::size_t hashCombine(std::size_t seed, std::size_t h) {
+	return wy::mix(seed ^ wy::secret[0], h ^ wy::secret[1]);
+}
+
+/// equal values of T have equal bytes, so a range of T can be hashed as raw memory
+template <class T>
+inline constexpr bool isBitwiseHashable =
+	std::is_integral_v<T> || std::is_enum_v<T> || (sizeof(T) == 1 && std::has_unique_object_representations_v<T>);
+
+template <class A>
+struct hash;
+
+/**
+ * @brief Hashes the elements of a contiguous range. Ranges of bitwise comparable values are hashed as the bytes they
+ * occupy; elements convertible to size_t (letters, tokens, states) are converted in blocks first, since their other
+ * members (like Token::data) take no part in equality.
+ */
+template <class T>
+std::size_t hashSpan(std::span<const T> x) {
+	if constexpr (isBitwiseHashable<T>) {
+		return hashBytes(x.data(), x.size_bytes());
+	} else if constexpr (requires(const T &t) { static_cast<std::size_t>(t); }) {
+		constexpr std::size_t BLOCK = 32;
+		std::size_t			  block[BLOCK];
+		std::size_t			  h = x.size();
+		for (std::size_t i = 0; i < x.size(); i += BLOCK) {
+			std::size_t n = std::min(BLOCK, x.size() - i);
+			for (std::size_t j = 0; j < n; ++j) {
+				block[j] = static_cast<std::size_t>(x[i + j]);
+			}
+			h = hashBytes(block, n * sizeof(std::size_t), h);
+		}
+		return h;
+	} else {
+		std::size_t h = x.size();
+		for (const auto &e : x) {
+			h = hashCombine(h, fl::hash<T>{}(e));
+		}
+		return h;
+	}
+}
+
 template <class A>
 struct hash {
 	constexpr hash() = default;
@@ -23,17 +140,13 @@ struct hash<Letter> {
 template <isLetter Letter>
 struct hash<std::span<Letter>> {
 	constexpr hash() = default;
-	constexpr size_t operator()(const std::span<Letter> &x) const {
-		return std::hash<std::string_view>()(std::string_view(reinterpret_cast<const char *>(x.data()), x.size()));
-	}
+	size_t operator()(const std::span<Letter> &x) const { return hashSpan(std::span<const Letter>(x)); }
 };
 
 template <isLetter Letter>
 struct hash<std::vector<Letter>> {
 	constexpr hash() = default;
-	constexpr size_t operator()(const std::vector<Letter> &x) const {
-		return std::hash<std::string_view>()(std::string_view(reinterpret_cast<const char *>(x.data()), x.size()));
-	}
+	size_t operator()(const std::vector<Letter> &x) const { return hashSpan(std::span<const Letter>(x)); }
 };
 
 template <isState State>
@@ -46,9 +159,12 @@ struct hash<State> {
 template <class... Args>
 struct hash<std::tuple<Args...>> {
 	constexpr hash() = default;
-	constexpr std::size_t operator()(const std::tuple<Args...> &t) const {
+	// combined in order, xor would map permutations of equal fields and pairs of equal fields to the same hash
+	std::size_t operator()(const std::tuple<Args...> &t) const {
 		return [&]<std::size_t... p>(std::index_sequence<p...>) {
-			return ((fl::hash<NthTypeOf<p, Args...>>{}(std::get<p>(t))) ^ ...);
+			std::size_t seed = 0;
+			((seed = hashCombine(seed, fl::hash<NthTypeOf<p, Args...>>{}(std::get<p>(t)))), ...);
+			return seed;
 		}(std::make_index_sequence<std::tuple_size_v<std::tuple<Args...>>>{});
 	}
 };
@@ -0,0 +1,458 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "parser.h"
+
+namespace fl {
+
+/**
+ * @brief Keeps the parse tree of a word between edits of its tokens. Every node remembers how many tokens it spans
+ * and the rule of the LL(1) table it was expanded with, so after an edit only the smallest subtree around it, whose
+ * decisions outside of it do not look at the changed tokens, is parsed again and spliced into the tree. While
+ * reparsing, the old tree is reused again as soon as the parser reaches one of the old nodes at the end of the
+ * subtree, past the edit, e.g. the rest of a right-recursive list of statements.
+ *
+ * The nodes on the way from the root to the last token only keep their position among their siblings, since they all
+ * end with the word, and an edit is found from the token before it up through the parents. So neither finding an edit
+ * nor updating the lengths after it walks down the spine of such a list.
+ *
+ * @tparam Letter - type of the symbols in the alphabet
+ */
+template <isLetter Letter>
+class IncrementalParser {
+   public:
+	using NodeID = std::uint32_t;
+
+   private:
+	using Symbol						 = typename SymbolTable<Letter>::Symbol;
+	static constexpr NodeID		   none	 = -1;
+	static constexpr std::uint32_t leaf	 = Parser<Letter>::noRule;
+
+	struct Node {
+		Letter				value = Letter::eps;
+		Symbol				symbol;
+		std::uint32_t		rule;	   // index of the rule it was expanded with, leaf for terminals and eps
+		std::uint32_t		length;	   // number of tokens it spans, not kept up to date if tail is set
+		std::vector<NodeID> children;
+		NodeID				parent;
+		std::uint32_t		index;	   // position among the children of parent
+		bool				tail;	   // the root or the last child of a tail node, so it ends with the word
+	};
+
+	const Parser<Letter> &parser;
+	std::vector<Letter>	  word;
+	std::vector<Node>	  nodes;
+	std::vector<NodeID>	  freeNodes;
+	NodeID				  root = none;
+	std::vector<NodeID>	  leafAt;	  // the leaf of each token in the tree, none for the eof
+	std::size_t			  treeEnd;	  // the number of tokens the tree spans
+
+	struct Attempt {
+		std::size_t tokensRead = 0;
+		bool		rejected   = false;		// a syntax error, the word is not in the language
+	};
+
+	// a node, with where it starts
+	struct PathEntry {
+		NodeID		id;
+		std::size_t begin;
+	};
+
+	NodeID newNode(const Letter value, Symbol symbol, std::uint32_t rule, std::uint32_t length) {
+		NodeID id;
+		if (freeNodes.empty()) {
+			id = nodes.size();
+			nodes.emplace_back();
+		} else {
+			id = freeNodes.back();
+			freeNodes.pop_back();
+		}
+		nodes[id].value	 = value;
+		nodes[id].symbol = symbol;
+		nodes[id].rule	 = rule;
+		nodes[id].length = length;
+		nodes[id].children.clear();
+		nodes[id].parent = none;
+		nodes[id].index	 = 0;
+		nodes[id].tail	 = false;
+		return id;
+	}
+
+	std::size_t lengthOf(PathEntry at) const { return nodes[at.id].tail ? treeEnd - at.begin : nodes[at.id].length; }
+
+	/// the parent of a node, none above the root. The siblings before a node are not tails, so their lengths are known
+	PathEntry up(PathEntry at) const {
+		const Node &n = nodes[at.id];
+		if (n.parent == none) return {none, 0};
+		const auto &siblings = nodes[n.parent].children;
+		for (std::size_t i = 0; i < n.index; ++i) {
+			at.begin -= nodes[siblings[i]].length;
+		}
+		return {n.parent, at.begin};
+	}
+
+	/// frees the subtree of a node, except the subtree of keep
+	void release(NodeID from, NodeID keep = none) {
+		std::vector<NodeID> stack = {from};
+		while (!stack.empty()) {
+			NodeID id = stack.back();
+			stack.pop_back();
+			if (id == keep) continue;
+			stack.insert(stack.end(), nodes[id].children.begin(), nodes[id].children.end());
+			freeNodes.push_back(id);
+		}
+	}
+
+	Symbol terminalAt(std::size_t offset) const {
+		if (offset >= word.size()) return SymbolTable<Letter>::none;
+		Symbol s = parser.symbols.find(word[offset]);
+		return parser.symbols.isTerminal(s) ? s : SymbolTable<Letter>::none;
+	}
+
+	std::uint32_t ruleFor(Symbol symbol, Symbol lookahead) const {
+		if (lookahead == SymbolTable<Letter>::none) return leaf;
+		const std::size_t T = parser.symbols.terminalCount();
+		return parser.table[(symbol - T) * T + lookahead];
+	}
+
+	/// whether the non-terminals in the subtree of an empty node still get the same rules with the given lookahead
+	bool sameRules(NodeID from, Symbol lookahead) const {
+		std::vector<NodeID> stack = {from};
+		while (!stack.empty()) {
+			const Node &n = nodes[stack.back()];
+			stack.pop_back();
+			if (n.rule == leaf) continue;
+			if (ruleFor(n.symbol, lookahead) != n.rule) return false;
+			stack.insert(stack.end(), n.children.begin(), n.children.end());
+		}
+		return true;
+	}
+
+	/// whether the empty nodes at the end of a subtree still get the same rules with the given lookahead
+	bool sameTrailingRules(NodeID from, Symbol lookahead) const {
+		for (NodeID id = from; id != none;) {
+			const auto &children = nodes[id].children;
+			id					 = none;
+			for (auto it = children.rbegin(); it != children.rend(); ++it) {
+				if (nodes[*it].length > 0) {
+					if (nodes[*it].rule != leaf) id = *it;
+					break;
+				}
+				if (!sameRules(*it, lookahead)) return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Whether the decisions outside of a node, which looked at its first token, are the same with the new token
+	 * there. These are the expansions of the ancestors that start with it and of the empty nodes right before it.
+	 */
+	bool sameContext(PathEntry at) const {
+		const Symbol lookahead = terminalAt(at.begin);
+		for (NodeID id = at.id; nodes[id].parent != none; id = nodes[id].parent) {
+			const Node &parent = nodes[nodes[id].parent];
+			for (std::size_t j = nodes[id].index; j > 0; --j) {
+				NodeID sibling = parent.children[j - 1];
+				if (nodes[sibling].length > 0) return sameTrailingRules(sibling, lookahead);
+				if (!sameRules(sibling, lookahead)) return false;
+			}
+			if (ruleFor(parent.symbol, lookahead) != parent.rule) return false;
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Parses the symbol of old again from begin. It has to end where old ends, shifted by delta, unless it
+	 * reaches one of the nodes at the end of old at a position past editEnd and with nothing else left to parse, in
+	 * which case that node is reused.
+	 *
+	 * @return the new node, or none if the parse failed or ended elsewhere
+	 */
+	NodeID reparse(NodeID old, std::size_t begin, std::size_t editEnd, std::ptrdiff_t delta, Attempt &attempt) {
+		struct Pending {
+			Symbol symbol;
+			NodeID parent;
+		};
+		const std::size_t	 end	= begin + lengthOf({old, begin}) + delta;
+		std::vector<Pending> stack	= {{nodes[old].symbol, none}};
+		std::size_t			 offset = begin;
+		NodeID				 result = none, reused = none;
+		std::vector<NodeID>	 created;
+
+		// the nodes of old that end with it, found in the order of their starts
+		NodeID		spine	   = old;
+		std::size_t spineBegin = begin;
+		auto		findOld	   = [&](Symbol symbol, std::size_t oldBegin) -> NodeID {
+			   while (spine != none && spineBegin <= oldBegin) {
+				   const Node &n = nodes[spine];
+				   if (spineBegin == oldBegin && n.symbol == symbol) return spine;
+				   for (std::size_t i = 0; i + 1 < n.children.size(); ++i) {
+					   spineBegin += nodes[n.children[i]].length;
+				   }
+				   NodeID last = n.children.back();
+				   spine	   = nodes[last].rule == leaf ? none : last;
+			   }
+			   return none;
+		};
+		auto attach = [&](NodeID parent, NodeID id) {
+			if (parent == none) result = id;
+			else nodes[parent].children.push_back(id);
+		};
+
+		bool failed = false;
+		while (!stack.empty()) {
+			const auto [symbol, parent] = stack.back();
+			stack.pop_back();
+			const Symbol lookahead = terminalAt(offset);
+			if (parser.symbols.isTerminal(symbol)) {
+				if (symbol != lookahead) {
+					failed = true;
+					break;
+				}
+				NodeID id = newNode(word[offset], symbol, leaf, 1);
+				created.push_back(id);
+				attach(parent, id);
+				++offset;
+				continue;
+			}
+			if (parent != none && stack.empty() && offset >= editEnd) {
+				reused = findOld(symbol, offset - delta);
+				if (reused != none) {
+					attach(parent, reused);
+					attempt.tokensRead += offset - begin;
+					nodes[reused].length = end - offset;	 // it ends where old ends
+					offset				 = end;
+					break;
+				}
+			}
+			const std::uint32_t r = ruleFor(symbol, lookahead);
+			if (r == leaf) {
+				failed = true;
+				break;
+			}
+			const auto &rule = parser.rules[r];
+			NodeID		id	 = newNode(rule.lhs, symbol, r, 0);
+			created.push_back(id);
+			attach(parent, id);
+			if (rule.production.empty()) {
+				NodeID eps = newNode(Letter::eps, SymbolTable<Letter>::none, leaf, 0);
+				created.push_back(eps);
+				nodes[id].children.push_back(eps);
+			}
+			const auto rhs = parser.rhsSymbols.begin() + rule.rhs;
+			for (std::size_t i = 0; i < rule.production.size(); ++i) {
+				stack.push_back({rhs[i], id});
+			}
+		}
+		if (reused == none) attempt.tokensRead += offset - begin;
+		attempt.rejected = failed;
+
+		if (failed || offset != end) {
+			for (NodeID id : created) {
+				freeNodes.push_back(id);
+			}
+			return none;
+		}
+		// the nodes were created parents first
+		for (NodeID id : created | std::views::reverse) {
+			if (nodes[id].rule == leaf) continue;
+			nodes[id].length = 0;
+			for (NodeID child : nodes[id].children) {
+				nodes[id].length += nodes[child].length;
+			}
+		}
+		nodes[result].parent = nodes[old].parent;
+		nodes[result].index	 = nodes[old].index;
+		nodes[result].tail	 = nodes[old].tail;
+		std::size_t position = begin;
+		for (NodeID id : created) {
+			if (nodes[id].rule == leaf) {
+				if (nodes[id].length > 0) leafAt[position++] = id;
+				continue;
+			}
+			const auto &children = nodes[id].children;
+			for (std::size_t i = 0; i < children.size(); ++i) {
+				nodes[children[i]].parent = id;
+				nodes[children[i]].index  = i;
+				nodes[children[i]].tail	  = nodes[id].tail && i + 1 == children.size();
+			}
+		}
+		release(old, reused);
+		return result;
+	}
+
+	/// replaces count elements at offset, moving the rest of the vector at most once
+	template <class T>
+	static void splice(std::vector<T> &v, std::size_t offset, std::size_t count, std::span<const T> replacement) {
+		const auto at	  = v.begin() + offset;
+		const auto common = std::min(count, replacement.size());
+		std::copy(replacement.begin(), replacement.begin() + common, at);
+		if (count > common) v.erase(at + common, at + count);
+		else v.insert(at + common, replacement.begin() + common, replacement.end());
+	}
+
+	/// parses the whole word, none if it fails
+	NodeID parseAll() {
+		if (word.empty() || word.back() != parser.g.eof) return none;
+		Attempt			  attempt;
+		const std::size_t oldEnd = treeEnd;
+		treeEnd					 = word.size() - 1;
+		NodeID start			 = newNode(parser.g.start, parser.startSymbol, leaf, 0);
+		nodes[start].tail		 = true;
+		NodeID result			 = reparse(start, 0, std::size_t(-1), 0, attempt);	   // nothing to reuse
+		if (result == none) {
+			freeNodes.push_back(start);
+			treeEnd = oldEnd;
+		}
+		return result;
+	}
+
+	/**
+	 * @brief The smallest node, other than a leaf, that contains the tokens [begin, end). It starts from the parents of
+	 * the token before them, up to one that also contains the token after them, which is on the way down from the
+	 * root, so it does not depend on how far the tokens are from the start of the word.
+	 */
+	PathEntry locate(std::size_t begin, std::size_t end) const {
+		PathEntry at = {root, 0};
+		if (begin > 0 && begin <= treeEnd) {
+			at = up({leafAt[begin - 1], begin - 1});
+			while (at.begin + lengthOf(at) <= end && at.begin + lengthOf(at) < treeEnd) {
+				at = up(at);
+			}
+		}
+		while (true) {
+			std::size_t childBegin = at.begin;
+			PathEntry	next = {none, 0}, touching = {none, 0};
+			const auto &children = nodes[at.id].children;
+			for (std::size_t i = 0; i < children.size(); ++i) {
+				const PathEntry	  child	   = {children[i], childBegin};
+				const std::size_t childEnd = childBegin + lengthOf(child);
+				if (nodes[child.id].rule != leaf && childBegin <= begin && end <= childEnd && childBegin < childEnd) {
+					// an insertion between two nodes goes to the second one
+					if (begin < childEnd) {
+						next = child;
+						break;
+					}
+					touching = child;
+				}
+				childBegin = childEnd;
+			}
+			if (next.id == none) next = touching;
+			if (next.id == none) return at;
+			at = next;
+		}
+	}
+
+   public:
+	/**
+	 * @brief Parses a word, which has to end with eof. If it fails, throws a ParseError
+	 */
+	IncrementalParser(const Parser<Letter> &parser, std::vector<Letter> word) : parser(parser), word(std::move(word)) {
+		leafAt.assign(this->word.size(), none);
+		root = parseAll();
+		if (root == none) {
+			parser.run(this->word, [](auto &&...) {}, [](auto &&...) {});
+			throw ParseError("the word does not end with eof", this->word.size());
+		}
+	}
+
+	/**
+	 * @brief Replaces count tokens at offset with the given ones and parses the changed part of the word again. If
+	 * the new word is not in the language, throws a ParseError and keeps the old word and tree
+	 *
+	 * @return the number of tokens that were parsed again
+	 */
+	std::size_t edit(std::size_t offset, std::size_t count, std::span<const Letter> replacement) {
+		if (offset + count > word.size()) throw std::out_of_range("edit past the end of the word");
+		const PathEntry		deepest = locate(offset, offset + count);
+		std::vector<Letter> removed(word.begin() + offset, word.begin() + offset + count);
+		std::vector<NodeID> removedLeaves(leafAt.begin() + offset, leafAt.begin() + offset + count);
+		splice(word, offset, count, replacement);
+		splice(leafAt, offset, count, std::span<const NodeID>(std::vector<NodeID>(replacement.size(), none)));
+
+		const std::ptrdiff_t delta	 = std::ptrdiff_t(replacement.size()) - std::ptrdiff_t(count);
+		const std::size_t	 editEnd = offset + replacement.size();
+		Attempt				 attempt;
+
+		for (PathEntry at = deepest; at.id != none && !attempt.rejected; at = up(at)) {
+			if (offset + count > at.begin + lengthOf(at)) continue;	 // reaches the eof after the root
+			if (offset == at.begin && !sameContext(at)) continue;
+
+			// a syntax error here would be one in the whole word too, so then the loop stops
+			NodeID replaced = reparse(at.id, at.begin, editEnd, delta, attempt);
+			if (replaced == none) continue;
+			const NodeID parent = nodes[replaced].parent;
+			if (parent == none) root = replaced;
+			else nodes[parent].children[nodes[replaced].index] = replaced;
+			// the tails end with the word, so only the ancestors up to the first one change
+			for (NodeID id = parent; id != none && !nodes[id].tail; id = nodes[id].parent) {
+				nodes[id].length += delta;
+			}
+			treeEnd += delta;
+			return attempt.tokensRead;
+		}
+
+		if (!attempt.rejected) {	 // e.g. the edit reaches the eof
+			NodeID replaced = parseAll();
+			if (replaced != none) {
+				release(root);
+				root = replaced;
+				return word.size() - 1;
+			}
+		}
+		try {
+			parser.run(word, [](auto &&...) {}, [](auto &&...) {});
+			throw ParseError("the word does not end with eof", word.size());
+		} catch (...) {
+			splice(word, offset, replacement.size(), std::span<const Letter>(removed));
+			splice(leafAt, offset, replacement.size(), std::span<const NodeID>(removedLeaves));
+			throw;
+		}
+	}
+
+	std::size_t edit(std::size_t offset, std::size_t count, const std::vector<Letter> &replacement) {
+		return edit(offset, count, std::span<const Letter>(replacement));
+	}
+
+	const std::vector<Letter> &getWord() const { return word; }
+
+	/// builds the flat parse tree, the same as Parser::parseFlat of the current word
+	ParseTree<Letter> tree(const typename ParseTree<Letter>::allocator_type &alloc = {}) const {
+		ParseTree<Letter>							tree(alloc);
+		std::vector<std::pair<NodeID, std::size_t>> stack;	   // the open nodes, with their next child
+		std::vector<NodeID>							built;	   // the finished children of the open nodes
+		std::vector<std::size_t>					starts;	   // where the children of each open node start
+
+		auto push = [&](NodeID id) {
+			if (nodes[id].rule == leaf) {
+				built.push_back(tree.addLeaf(nodes[id].value));
+			} else {
+				starts.push_back(built.size());
+				stack.push_back({id, 0});
+			}
+		};
+		push(root);
+		while (!stack.empty()) {
+			auto [id, next] = stack.back();
+			if (next < nodes[id].children.size()) {
+				++stack.back().second;
+				push(nodes[id].children[next]);
+			} else {
+				NodeID added = tree.addNode(nodes[id].value, std::span(built).subspan(starts.back()));
+				built.resize(starts.back());
+				built.push_back(added);
+				starts.pop_back();
+				stack.pop_back();
+			}
+		}
+		return tree;
+	}
+};
+
+}	  // namespace fl
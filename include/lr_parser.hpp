@@ -0,0 +1,529 @@
+#pragma once
+
+#include <cstdint>
+#include <format>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "bitset.hpp"
+#include "cfg.h"
+#include "parser.h"
+#include "symbol_table.hpp"
+
+namespace fl {
+
+/**
+ * @brief A shift-reduce parser for the same CFGs that Parser takes, which also handles left-recursive grammars like
+ * e -> e+t | t and builds the same parse trees and ASTs. The states are the item sets of canonical LR(1), merged when
+ * their cores are the same for LALR(1), and the actions and gotos are kept in dense tables indexed by state and
+ * symbol, so a word is parsed in time linear in its length.
+ *
+ * @tparam Letter - type of the symbols in the alphabet
+ */
+template <isLetter Letter>
+class LRParser {
+   public:
+	enum class Kind : std::uint8_t { LALR1, LR1 };
+
+   private:
+	using Symbol = typename SymbolTable<Letter>::Symbol;
+
+	struct Rule {
+		Symbol								  lhs;
+		std::uint32_t						  rhs;		 // start of the right side in rhsSymbols
+		std::uint32_t						  item;		 // the item with the dot at the start of the right side
+		typename CFG<Letter>::Production	  production;
+		typename CFG<Letter>::NonTerminalData data;
+	};
+
+	// an action is a shift to a state, a reduction by a rule or the accepting reduction of the start symbol, with the
+	// kind in its lowest two bits
+	using Action					  = std::uint32_t;
+	static constexpr Action error	  = 0;
+	static constexpr Action shiftTo	  = 1;
+	static constexpr Action reduceBy  = 2;
+	static constexpr Action accepting = 3;
+
+	static constexpr std::uint32_t noState = -1;
+	static constexpr std::uint32_t noRule  = -1;
+
+	CFG<Letter>			g;
+	Kind				kind;
+	SymbolTable<Letter> symbols;
+	Symbol				eofSymbol = 0;
+
+	std::vector<Rule>					rules;	   // rules[0] is the added start rule S' -> S
+	std::vector<Symbol>					rhsSymbols;
+	std::vector<std::vector<std::uint32_t>> rulesOf;	 // [non-terminal - terminalCount] -> indices in rules
+
+	// an item is a rule with a dot in its right side, numbered so that moving the dot right adds one
+	std::vector<std::uint32_t> itemRule;
+	std::vector<BitSet>		   itemFirst;		// FIRST of what is after the dot
+	std::vector<bool>		   itemNullable;	// whether what is after the dot derives eps
+
+	struct ItemSet {
+		std::vector<std::uint32_t> kernel;	   // sorted items
+		std::vector<BitSet>		   lookaheads;
+	};
+	std::vector<ItemSet>											 states;
+	std::map<std::vector<std::uint32_t>, std::vector<std::uint32_t>> statesByCore;
+
+	std::vector<Action>		   actions;	   // [state][terminal]
+	std::vector<std::uint32_t> gotos;	   // [state][non-terminal - terminalCount]
+
+	std::size_t terminalCount() const { return symbols.terminalCount(); }
+	bool		isTerminal(Symbol s) const { return symbols.isTerminal(s); }
+	std::size_t length(const Rule &rule) const { return rule.production.size(); }
+
+	Symbol symbolOf(const Letter l) const {
+		Symbol s = symbols.find(l);
+		if (s == SymbolTable<Letter>::none) {
+			throw std::runtime_error(std::format("'{}' is neither a terminal nor a non-terminal", l));
+		}
+		return s;
+	}
+
+	void addRule(const Symbol lhs, const typename CFG<Letter>::Production &v,
+				 const typename CFG<Letter>::NonTerminalData &data) {
+		rules.push_back({lhs, std::uint32_t(rhsSymbols.size()), std::uint32_t(itemRule.size()), v, data});
+		for (const auto l : v.rhs) {
+			rhsSymbols.push_back(symbolOf(l));
+		}
+		itemRule.insert(itemRule.end(), v.size() + 1, std::uint32_t(rules.size() - 1));
+	}
+
+	/// the symbol after the dot of an item, or none if the dot is at the end
+	Symbol afterDot(const std::uint32_t item) const {
+		const auto		 &rule = rules[itemRule[item]];
+		const std::size_t dot  = item - rule.item;
+		return dot < length(rule) ? rhsSymbols[rule.rhs + dot] : SymbolTable<Letter>::none;
+	}
+
+	void numberRules() {
+		for (const auto l : g.terminals) {
+			if (g.nonTerminals.contains(l)) {
+				throw std::runtime_error("Grammar is not LR(1): intersection between terminals and nonterminals");
+			}
+		}
+
+		// the end of the word is a terminal too, even if the grammar does not list it
+		std::vector<Letter> alphabet(g.terminals.begin(), g.terminals.end());
+		if (!g.terminals.contains(g.eof)) alphabet.push_back(g.eof);
+		symbols = SymbolTable<Letter>(alphabet);
+		for (const auto l : g.nonTerminals) {
+			symbols.add(l);
+		}
+		eofSymbol = symbols.find(g.eof);
+		rulesOf.assign(symbols.nonTerminalCount(), {});
+
+		const Symbol start = symbolOf(g.start);
+		if (isTerminal(start)) throw std::runtime_error("The start symbol of the grammar is a terminal");
+		addRule(symbols.size(), std::vector<Letter>{g.start}, {});
+		for (const auto &[A, v] : g.rules) {
+			auto NTData = g.nonTerminalData.find(A);
+			addRule(symbolOf(A), v,
+					NTData != g.nonTerminalData.end() ? NTData->second : typename CFG<Letter>::NonTerminalData{});
+			rulesOf[rules.back().lhs - terminalCount()].push_back(rules.size() - 1);
+		}
+
+		const auto nullable = g.findNullables();
+		const auto first	= g.findFirsts(nullable);
+		std::vector<BitSet> firstOf(symbols.size(), BitSet(terminalCount()));
+		std::vector<bool>	nullableOf(symbols.size(), false);
+		for (Symbol s = 0; s < symbols.size(); ++s) {
+			if (isTerminal(s)) {
+				firstOf[s].insert(s);
+				continue;
+			}
+			const Letter A = symbols.letter(s);
+			nullableOf[s]  = nullable.find(A)->second;
+			for (const auto l : first.find(A)->second) {
+				if (symbols.contains(l) && isTerminal(symbols.find(l))) firstOf[s].insert(symbols.find(l));
+			}
+		}
+
+		// FIRST of every suffix of every right side, from the shortest suffix to the longest
+		itemFirst.assign(itemRule.size(), BitSet(terminalCount()));
+		itemNullable.assign(itemRule.size(), true);
+		for (const auto &rule : rules) {
+			for (std::size_t dot = length(rule); dot-- > 0;) {
+				const Symbol		X	 = rhsSymbols[rule.rhs + dot];
+				const std::uint32_t item = rule.item + dot;
+				itemFirst[item]			 = firstOf[X];
+				if (nullableOf[X]) {
+					itemFirst[item].merge(itemFirst[item + 1]);
+					itemNullable[item] = itemNullable[item + 1];
+				} else {
+					itemNullable[item] = false;
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief Closes the kernel of a state and calls goTo(X, kernel, lookaheads) for every symbol X that some item
+	 * has after its dot, with the kernel of the state that reading X leads to, and reduce(rule, lookaheads) for every
+	 * item with the dot at its end. The items that the closure adds have the dot at the start, so they are kept as the
+	 * non-terminals they predict, with one lookahead set for all the rules of a non-terminal. reduce also gets how many
+	 * predictions away from the kernel the item is.
+	 */
+	template <class GoTo, class Reduce>
+	void expand(const ItemSet &state, GoTo &&goTo, Reduce &&reduce) const {
+		const std::size_t		 T = terminalCount();
+		std::vector<BitSet>		 predicted(symbols.nonTerminalCount());
+		std::vector<bool>		 seen(symbols.nonTerminalCount(), false);
+		std::vector<std::size_t> depth(symbols.nonTerminalCount());
+		std::vector<Symbol>		 order;
+		std::vector<std::size_t> work;
+
+		auto predict = [&](const std::uint32_t item, const BitSet &lookaheads, const std::size_t d) {
+			const Symbol B = afterDot(item);
+			if (B == SymbolTable<Letter>::none || isTerminal(B)) return;
+			BitSet &set	  = predicted[B - T];
+			bool	added = !seen[B - T];
+			if (added) {
+				seen[B - T]	 = true;
+				depth[B - T] = d;
+				set			 = BitSet(T);
+				order.push_back(B);
+			}
+			added = set.merge(itemFirst[item + 1]) || added;
+			if (itemNullable[item + 1]) added = set.merge(lookaheads) || added;
+			if (added) work.push_back(B - T);
+		};
+
+		for (std::size_t i = 0; i < state.kernel.size(); ++i) {
+			predict(state.kernel[i], state.lookaheads[i], 1);
+		}
+		// first in first out, so every non-terminal is seen first at its smallest depth
+		for (std::size_t w = 0; w < work.size(); ++w) {
+			const std::size_t B			 = work[w];
+			const BitSet	  lookaheads = predicted[B];
+			for (const auto r : rulesOf[B]) {
+				predict(rules[r].item, lookaheads, depth[B] + 1);
+			}
+		}
+
+		std::map<Symbol, ItemSet> next;
+		auto advance = [&](const std::uint32_t item, const BitSet &lookaheads, const std::size_t d) {
+			const Symbol X = afterDot(item);
+			if (X == SymbolTable<Letter>::none) {
+				reduce(itemRule[item], lookaheads, d);
+				return;
+			}
+			auto &target = next[X];
+			target.kernel.push_back(item + 1);
+			target.lookaheads.push_back(lookaheads);
+		};
+		for (std::size_t i = 0; i < state.kernel.size(); ++i) {
+			advance(state.kernel[i], state.lookaheads[i], 0);
+		}
+		for (const auto B : order) {
+			for (const auto r : rulesOf[B - T]) {
+				advance(rules[r].item, predicted[B - T], depth[B - T]);
+			}
+		}
+
+		for (auto &[X, target] : next) {
+			// the items come from different rules or different dots, so they are distinct and only need sorting
+			std::vector<std::size_t> byItem(target.kernel.size());
+			std::iota(byItem.begin(), byItem.end(), 0);
+			std::ranges::sort(byItem, {}, [&](const std::size_t i) { return target.kernel[i]; });
+			ItemSet sorted;
+			for (const auto i : byItem) {
+				sorted.kernel.push_back(target.kernel[i]);
+				sorted.lookaheads.push_back(std::move(target.lookaheads[i]));
+			}
+			goTo(X, sorted);
+		}
+	}
+
+	std::string describe(const Action a) const {
+		if ((a & 3) == shiftTo) return "shift";
+		const auto &rule = rules[(a & 3) == accepting ? 0 : a >> 2];
+		return std::format("reduce {} -> {}", rule.lhs < symbols.size() ? symbols.letter(rule.lhs) : g.start,
+						   rule.production.rhs);
+	}
+
+	/**
+	 * @brief The state with the given kernel, a new one if there is none. For LALR(1) the lookaheads are merged into
+	 * the state with the same core, and changed tells whether that added any
+	 */
+	std::uint32_t findState(ItemSet &&kernel, bool &changed) {
+		changed			 = false;
+		auto &candidates = statesByCore[kernel.kernel];
+		for (const auto s : candidates) {
+			if (kind == Kind::LR1) {
+				if (states[s].lookaheads == kernel.lookaheads) return s;
+				continue;
+			}
+			for (std::size_t i = 0; i < kernel.lookaheads.size(); ++i) {
+				changed = states[s].lookaheads[i].merge(kernel.lookaheads[i]) || changed;
+			}
+			return s;
+		}
+		candidates.push_back(states.size());
+		states.push_back(std::move(kernel));
+		changed = true;
+		return states.size() - 1;
+	}
+
+	void build() {
+		numberRules();
+
+		BitSet atEnd(terminalCount());
+		atEnd.insert(eofSymbol);
+		states.push_back({{rules[0].item}, {atEnd}});
+		statesByCore[states[0].kernel].push_back(0);
+
+		// states whose lookaheads grew after they were expanded are expanded again, until nothing changes
+		std::vector<std::uint32_t> work = {0};
+		std::vector<bool>		   queued(1, true);
+		while (!work.empty()) {
+			const std::uint32_t s = work.back();
+			work.pop_back();
+			queued[s] = false;
+			expand(
+				ItemSet(states[s]),
+				[&](Symbol, ItemSet &target) {
+					bool				changed;
+					const std::uint32_t t = findState(std::move(target), changed);
+					queued.resize(states.size(), false);
+					if (changed && !queued[t]) {
+						queued[t] = true;
+						work.push_back(t);
+					}
+				},
+				[](std::uint32_t, const BitSet &, std::size_t) {});
+		}
+
+		const std::size_t T = terminalCount(), N = symbols.nonTerminalCount();
+		actions.assign(states.size() * T, error);
+		gotos.assign(states.size() * N, noState);
+
+		// an Optional of a Repeat derives eps through two empty rules, which Parser resolves by taking the empty rule of
+		// the outer non-terminal, so a conflict between two empty rules goes to the one predicted closer to the kernel
+		std::vector<std::string> conflicts;
+		std::vector<std::size_t> emptyDepth(T);
+		auto setAction = [&](const std::uint32_t s, const Symbol t, const Action a, const std::size_t d = 0) {
+			Action	  &entry = actions[s * T + t];
+			const bool empty = (a & 3) == reduceBy && length(rules[a >> 2]) == 0;
+			if (empty && (entry & 3) == reduceBy && length(rules[entry >> 2]) == 0 && emptyDepth[t] != d) {
+				if (d < emptyDepth[t]) {
+					entry		  = a;
+					emptyDepth[t] = d;
+				}
+				return;
+			}
+			if (empty) emptyDepth[t] = d;
+			if (entry != error && entry != a) {
+				const bool shifts = (entry & 3) == shiftTo || (a & 3) == shiftTo;
+				conflicts.push_back(std::format("{} conflict in state {} on '{}': {} or {}",
+												shifts ? "shift/reduce" : "reduce/reduce", s, symbols.letter(t),
+												describe(entry), describe(a)));
+			}
+			entry = a;
+		};
+
+		for (std::uint32_t s = 0; s < states.size(); ++s) {
+			expand(
+				ItemSet(states[s]),
+				[&](const Symbol X, ItemSet &target) {
+					bool				changed;
+					const std::uint32_t t = findState(std::move(target), changed);
+					if (isTerminal(X)) setAction(s, X, t << 2 | shiftTo);
+					else gotos[s * N + X - T] = t;
+				},
+				[&](const std::uint32_t r, const BitSet &lookaheads, const std::size_t d) {
+					lookaheads.forEach([&](const std::size_t t) {
+						setAction(s, t, r == 0 ? accepting : Action(r << 2 | reduceBy), d);
+					});
+				});
+		}
+
+		if (!conflicts.empty()) {
+			std::string msg = std::format("Grammar is not {}:", kind == Kind::LR1 ? "LR(1)" : "LALR(1)");
+			for (const auto &c : conflicts) {
+				msg += "\n" + c;
+			}
+			throw std::runtime_error(msg);
+		}
+	}
+
+	/**
+	 * @brief Runs the tables on a word that ends with eof, calling shift(offset) for every terminal it reads and
+	 * reduce(rule) for every reduction. If the word is rejected, throws a ParseError if throwOnError is set
+	 */
+	template <class Shift, class Reduce>
+	bool run(const std::vector<Letter> &word, bool throwOnError, Shift &&shift, Reduce &&reduce) const {
+		const std::size_t		   T = terminalCount(), N = symbols.nonTerminalCount();
+		std::vector<std::uint32_t> stack = {0};
+		for (std::size_t offset = 0;;) {
+			const Symbol t = offset < word.size() ? symbols.find(word[offset]) : SymbolTable<Letter>::none;
+			const Action a = t != SymbolTable<Letter>::none && isTerminal(t) ? actions[stack.back() * T + t] : error;
+			switch (a & 3) {
+				case shiftTo:
+					shift(offset++);
+					stack.push_back(a >> 2);
+					break;
+				case reduceBy: {
+					const auto &rule = rules[a >> 2];
+					stack.resize(stack.size() - length(rule));
+					reduce(a >> 2);
+					stack.push_back(gotos[stack.back() * N + rule.lhs - T]);
+					break;
+				}
+				case accepting:
+					if (offset + 1 == word.size()) return true;
+					[[fallthrough]];
+				default:
+					if (throwOnError) throw ParseError(explain(stack.back(), word, offset), offset);
+					return false;
+			}
+		}
+	}
+
+	std::string explain(const std::uint32_t state, const std::vector<Letter> &word, const std::size_t offset) const {
+		if (offset >= word.size()) return "unexpected end of file";
+		if (!symbols.contains(word[offset]) || !isTerminal(symbols.find(word[offset]))) {
+			return std::format("unexpected '{}' - not a valid terminal", word[offset]);
+		}
+		std::vector<Letter> expected;
+		for (Symbol t = 0; t < terminalCount(); ++t) {
+			if (actions[state * terminalCount() + t] != error) expected.push_back(symbols.letter(t));
+		}
+		if (word[offset] == g.eof) return std::format("expected one of {}, but got end of file", expected);
+		return std::format("expected one of {}, but got '{}'", expected, word[offset]);
+	}
+
+	// a node of the AST whose parent has not been reduced yet, so it is not known yet whether it stays in the tree
+	struct OpenNode {
+		Letter										value;
+		std::vector<std::unique_ptr<ParseNode<Letter>>> children;
+		std::uint32_t								rule;	  // noRule for a terminal
+	};
+
+	/// puts a finished node into its parent, the way makeAST does when it leaves a non-terminal
+	void close(OpenNode &child, OpenNode &parent) const {
+		const auto		 &rule		  = rules[child.rule];
+		const auto		 &NTData	  = rule.data;
+		const Letter	  replaceWith = rule.production.replaceWith;
+		const std::size_t childCount  = child.children.size();
+
+		// throw out the node if it is empty and we ignore empty
+		if (NTData.ignoreEmpty && childCount == 0) return;
+		// throw out the node if it has a single child and we ignore single child
+		if (NTData.ignoreSingleChild && childCount == 1) {
+			if (replaceWith != Letter::eps) { parent.value = replaceWith; }
+			parent.children.push_back(std::move(child.children[0]));
+			return;
+		}
+
+		if (NTData.upwardSpillThreshold < 0 || childCount > std::size_t(NTData.upwardSpillThreshold)) {
+			const Letter value = replaceWith != Letter::eps ? replaceWith : child.value;
+			parent.children.push_back(std::make_unique<ParseNode<Letter>>(value, std::move(child.children)));
+		} else {	 // spill upwards if we have few children
+			for (auto &c : child.children) {
+				parent.children.push_back(std::move(c));
+			}
+		}
+	}
+
+   public:
+	/**
+	 * @brief Construct an LRParser from a grammar. Throws if the grammar is not LALR(1), or LR(1) for Kind::LR1,
+	 * listing the conflicts in the tables
+	 *
+	 * @param grammar
+	 * @param kind - LALR1 merges the states with the same core, LR1 keeps the canonical states
+	 */
+	LRParser(const CFG<Letter> &grammar, Kind kind = Kind::LALR1) : g(grammar), kind(kind) {
+		try {
+			build();
+		} catch (...) { std::throw_with_nested(std::runtime_error("Failed to create parser for grammar")); }
+	}
+
+	std::size_t		   stateCount() const { return states.size(); }
+	const CFG<Letter> &getGrammar() const { return g; }
+
+	/**
+	 * @brief Checks whether a word, ending with eof, is in the language of the grammar
+	 */
+	bool recognize(const std::vector<Letter> &word) const {
+		return run(word, false, [](std::size_t) {}, [](std::uint32_t) {});
+	}
+
+	template <typename U = Letter>
+		requires std::is_constructible_v<Letter, char>
+	bool recognize(const std::string &word) const {
+		return recognize(std::vector<Letter>(word.begin(), word.end()));
+	}
+
+	/**
+	 * @brief parses a word and builds the same parse tree as Parser::parse. If it fails, throws a ParseError
+	 *
+	 * @param word
+	 * @return std::unique_ptr<ParseNode<Letter>>
+	 */
+	std::unique_ptr<ParseNode<Letter>> parse(const std::vector<Letter> &word) const {
+		std::vector<std::unique_ptr<ParseNode<Letter>>> stack;
+		run(
+			word, true,
+			[&](const std::size_t offset) { stack.push_back(std::make_unique<ParseNode<Letter>>(word[offset])); },
+			[&](const std::uint32_t r) {
+				const auto								   &rule = rules[r];
+				std::vector<std::unique_ptr<ParseNode<Letter>>> children(
+					std::make_move_iterator(stack.end() - length(rule)), std::make_move_iterator(stack.end()));
+				stack.resize(stack.size() - length(rule));
+				if (children.empty()) children.push_back(std::make_unique<ParseNode<Letter>>(Letter::eps));
+				stack.push_back(std::make_unique<ParseNode<Letter>>(symbols.letter(rule.lhs), std::move(children)));
+			});
+		return std::move(stack.back());
+	}
+
+	/**
+	 * @brief parses a word and builds the same AST as Parser::ASTparse. If it fails, throws a ParseError
+	 *
+	 * @param word
+	 * @return std::unique_ptr<ParseNode<Letter>>
+	 */
+	std::unique_ptr<ParseNode<Letter>> ASTparse(const std::vector<Letter> &word) const {
+		std::vector<OpenNode> stack;
+		run(
+			word, true, [&](const std::size_t offset) { stack.push_back({word[offset], {}, noRule}); },
+			[&](const std::uint32_t r) {
+				const auto &rule  = rules[r];
+				const auto	first = stack.size() - length(rule);
+				OpenNode	node{symbols.letter(rule.lhs), {}, r};
+				for (std::size_t i = 0; i < length(rule); ++i) {
+					auto &child = stack[first + i];
+					if (child.rule != noRule) close(child, node);
+					else if (!rule.production.ignore[i]) {
+						node.children.push_back(std::make_unique<ParseNode<Letter>>(child.value));
+					}
+				}
+				stack.erase(stack.begin() + first, stack.end());
+				stack.push_back(std::move(node));
+			});
+		return std::make_unique<ParseNode<Letter>>(stack.back().value, std::move(stack.back().children));
+	}
+
+	template <typename U = Letter>
+	std::unique_ptr<ParseNode<Letter>> parse(const std::string &word) const {
+		std::vector<Letter> w(word.begin(), word.end());
+		if (word.back() != Letter::eof) w.push_back(Letter::eof);
+		return parse(w);
+	}
+
+	template <typename U = Letter>
+	std::unique_ptr<ParseNode<Letter>> ASTparse(const std::string &word) const {
+		std::vector<Letter> w(word.begin(), word.end());
+		if (word.back() != Letter::eof) w.push_back(Letter::eof);
+		return ASTparse(w);
+	}
+};
+
+}	  // namespace fl
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "concepts.hpp"
+#include "parse_tree.hpp"
+
+namespace fl {
+
+/**
+ * @brief A shared packed parse forest: all the parse trees of a word, with the common subtrees stored once. A symbol
+ * node stands for a symbol deriving a span of the word, and each of its packed nodes is one rule that derives it. The
+ * right sides of the rules are binarized into intermediate nodes for their prefixes, whose packed nodes are the ways
+ * to split the span between the prefix without its last symbol and that symbol. That keeps the forest within O(n^3)
+ * nodes even when the number of trees is exponential.
+ *
+ * @tparam Letter - type of the symbols in the alphabet
+ */
+template <isLetter Letter>
+class ParseForest {
+   public:
+	using NodeID				 = std::uint32_t;
+	static constexpr NodeID none = -1;
+
+	struct Node {
+		Letter		  value;	   // the symbol, or the left side of the rule for an intermediate node
+		std::uint32_t start;	   // the span of the word that the node derives
+		std::uint32_t end;
+		std::uint32_t firstPacked;
+		std::uint32_t packedCount;
+		bool		  intermediate;
+	};
+
+	/**
+	 * @brief One way to derive a node. For a symbol node, right is the intermediate node of the whole right side of a
+	 * rule, or none for an empty rule. For an intermediate node, left is the node of the prefix without its last
+	 * symbol, or none if that is empty, and right is the symbol node of the last symbol.
+	 */
+	struct Packed {
+		NodeID left;
+		NodeID right;
+	};
+
+   private:
+	std::vector<Node>	nodes;
+	std::vector<Packed> packed;
+	NodeID				rootID = none;
+
+   public:
+	NodeID addNode(const Letter value, std::uint32_t start, std::uint32_t end, bool intermediate) {
+		nodes.push_back({value, start, end, 0, 0, intermediate});
+		return NodeID(nodes.size() - 1);
+	}
+
+	/// sets the packed nodes of a node, once it is known how it is derived
+	void setPacked(NodeID id, std::span<const Packed> alternatives) {
+		nodes[id].firstPacked = packed.size();
+		nodes[id].packedCount = alternatives.size();
+		packed.insert(packed.end(), alternatives.begin(), alternatives.end());
+	}
+
+	void setRoot(NodeID id) { rootID = id; }
+
+	bool		empty() const { return rootID == none; }
+	NodeID		root() const { return rootID; }
+	std::size_t size() const { return nodes.size(); }
+	std::size_t packedSize() const { return packed.size(); }
+
+	const Node &operator[](NodeID id) const { return nodes[id]; }
+	bool		isLeaf(NodeID id) const { return !nodes[id].intermediate && nodes[id].packedCount == 0; }
+
+	std::span<const Packed> alternatives(NodeID id) const {
+		return std::span<const Packed>(packed.data() + nodes[id].firstPacked, nodes[id].packedCount);
+	}
+
+	/// whether the word has more than one parse tree
+	bool ambiguous() const {
+		return std::ranges::any_of(nodes, [](const Node &n) { return n.packedCount > 1; });
+	}
+
+	/// takes the first alternative everywhere
+	struct FirstAlternative {
+		std::size_t operator()(const ParseForest &, NodeID, std::span<const Packed>) const { return 0; }
+	};
+
+	/**
+	 * @brief Goes through the parse trees in the forest one at a time, building each one only when it is asked for.
+	 * choose(forest, node, alternatives) says which packed node of an ambiguous node to try first, the others come
+	 * after it in order. A derivation that would come back to a node it is already under, through a cycle like A -> A,
+	 * is skipped, so there are finitely many trees.
+	 */
+	template <class Choose = FirstAlternative>
+	class TreeEnumerator {
+		const ParseForest *forest;
+		Choose			   choose;
+		// for every ambiguous node met so far in the current tree, in preorder: the alternative taken and the number
+		// of alternatives
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> decisions;
+		bool												 started = false;
+		bool												 done	 = false;
+
+		struct Frame {
+			NodeID				id;
+			ParseNode<Letter> *target;
+			std::uint32_t		parent;	   // index of the frame of the parent symbol node
+		};
+
+		/// builds the tree that the decisions lead to, making new ones as needed, or nullptr if it runs into a cycle
+		std::unique_ptr<ParseNode<Letter>> build() {
+			const ParseForest &f	= *forest;
+			std::size_t		   used = 0;
+
+			auto decide = [&](NodeID id) -> const Packed & {
+				const auto options = f.alternatives(id);
+				if (options.size() == 1) return options[0];
+				if (used == decisions.size()) decisions.push_back({0, std::uint32_t(options.size())});
+				const std::uint32_t k		  = decisions[used++].first;
+				const std::size_t	preferred = std::min(choose(f, id, options), options.size() - 1);
+				return options[k == 0 ? preferred : k <= preferred ? k - 1 : k];
+			};
+
+			auto result = std::make_unique<ParseNode<Letter>>(f[f.root()].value);
+
+			std::vector<Frame>		   frames = {{f.root(), result.get(), std::uint32_t(-1)}};
+			std::vector<std::uint32_t> stack  = {0};
+			std::vector<NodeID>		   children;
+			while (!stack.empty()) {
+				const std::uint32_t current = stack.back();
+				stack.pop_back();
+				const auto [id, target, parent] = frames[current];
+				if (f.isLeaf(id)) continue;
+
+				// only a node with the same span can be the same node, and those are right above it
+				for (auto a = parent; a != std::uint32_t(-1); a = frames[a].parent) {
+					const Node &above = f[frames[a].id];
+					if (above.start != f[id].start || above.end != f[id].end) break;
+					if (frames[a].id == id) {
+						decisions.resize(used);
+						return nullptr;
+					}
+				}
+
+				const Packed &rule = decide(id);
+				if (rule.right == none) {
+					target->children.push_back(std::make_unique<ParseNode<Letter>>(Letter::eps));
+					continue;
+				}
+				children.clear();
+				for (NodeID prefix = rule.right; prefix != none;) {
+					const Packed &split = decide(prefix);
+					children.push_back(split.right);
+					prefix = split.left;
+				}
+				for (const auto child : children | std::views::reverse) {
+					target->children.push_back(std::make_unique<ParseNode<Letter>>(f[child].value));
+					frames.push_back({child, target->children.back().get(), current});
+				}
+				for (std::size_t k = 0; k < children.size(); ++k) {
+					stack.push_back(frames.size() - 1 - k);
+				}
+			}
+			decisions.resize(used);
+			return result;
+		}
+
+	   public:
+		TreeEnumerator(const ParseForest &forest, Choose choose = {}) : forest(&forest), choose(std::move(choose)) {}
+
+		/// the next parse tree, or nullptr when there are no more
+		std::unique_ptr<ParseNode<Letter>> next() {
+			if (done || forest->empty()) return nullptr;
+			while (true) {
+				if (started) {
+					while (!decisions.empty() && ++decisions.back().first == decisions.back().second) {
+						decisions.pop_back();
+					}
+					if (decisions.empty()) {
+						done = true;
+						return nullptr;
+					}
+				}
+				started = true;
+				if (auto tree = build()) return tree;
+			}
+		}
+	};
+
+	template <class Choose = FirstAlternative>
+	TreeEnumerator<Choose> trees(Choose choose = {}) const {
+		return TreeEnumerator<Choose>(*this, std::move(choose));
+	}
+
+	/**
+	 * @brief Extracts a single parse tree, taking the alternative that choose(forest, node, alternatives) prefers at
+	 * every ambiguous node, unless it leads into a cycle
+	 *
+	 * @return the tree, or nullptr if the forest is empty
+	 */
+	template <class Choose = FirstAlternative>
+	std::unique_ptr<ParseNode<Letter>> extract(Choose choose = {}) const {
+		return trees(std::move(choose)).next();
+	}
+};
+
+}	  // namespace fl
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <ostream>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace fl {
+
+/**
+ * @brief A node in a parse tree
+ *
+ * @tparam Letter - type of the symbols in the alphabet
+ */
+template <class Letter>
+struct ParseNode {
+	Letter											value;
+	std::vector<std::unique_ptr<ParseNode<Letter>>> children;
+
+	ParseNode(const Letter value) : value(value) {}
+	ParseNode(const Letter value, std::vector<std::unique_ptr<ParseNode<Letter>>> &&children)
+		: value(value), children(std::move(children)) {}
+};
+
+/**
+ * @brief A parse tree stored in two flat arrays: the nodes and, for each node, the contiguous range of its children
+ * in an array of node ids. A node can only be added after its children, so the root is the last node and a tree built
+ * by a parser lies in post-order. Building it takes a few bulk allocations instead of one per node, and with a
+ * monotonic_buffer_resource both arrays come from the arena.
+ *
+ * @tparam Letter - type of the symbols in the alphabet
+ */
+template <class Letter>
+class ParseTree {
+   public:
+	using NodeID		 = std::uint32_t;
+	using allocator_type = std::pmr::polymorphic_allocator<>;
+
+	struct Node {
+		Letter value;
+		NodeID firstChild;	   // index in edges of the first child
+		NodeID childCount;
+	};
+
+   private:
+	std::pmr::vector<Node>	 nodes;
+	std::pmr::vector<NodeID> edges;
+
+   public:
+	ParseTree() : ParseTree(allocator_type()) {}
+	explicit ParseTree(const allocator_type &alloc) : nodes(alloc), edges(alloc) {}
+
+	allocator_type get_allocator() const { return nodes.get_allocator(); }
+
+	void reserve(std::size_t nodeCount, std::size_t edgeCount) {
+		nodes.reserve(nodeCount);
+		edges.reserve(edgeCount);
+	}
+
+	NodeID addLeaf(const Letter value) {
+		nodes.push_back({value, NodeID(edges.size()), 0});
+		return NodeID(nodes.size() - 1);
+	}
+
+	/// adds a node whose children are the given, already added nodes
+	NodeID addNode(const Letter value, std::span<const NodeID> children) {
+		nodes.push_back({value, NodeID(edges.size()), NodeID(children.size())});
+		edges.insert(edges.end(), children.begin(), children.end());
+		return NodeID(nodes.size() - 1);
+	}
+
+	bool		empty() const { return nodes.empty(); }
+	std::size_t size() const { return nodes.size(); }
+	NodeID		root() const { return NodeID(nodes.size() - 1); }
+
+	const Node &operator[](NodeID id) const { return nodes[id]; }
+	Letter		value(NodeID id) const { return nodes[id].value; }
+
+	std::span<const NodeID> children(NodeID id) const {
+		return std::span<const NodeID>(edges.data() + nodes[id].firstChild, nodes[id].childCount);
+	}
+
+	/// iterates all nodes in the order they were added
+	auto begin() const { return nodes.begin(); }
+	auto end() const { return nodes.end(); }
+
+	void clear() {
+		nodes.clear();
+		edges.clear();
+	}
+
+	/**
+	 * @brief Walks the subtree of a node depth-first without recursion. enter(id, depth) is called before the children
+	 * of a node and leave(id, depth) after them. If enter returns a bool, false skips the children of that node.
+	 */
+	template <class Enter, class Leave>
+	void visit(NodeID from, Enter &&enter, Leave &&leave) const {
+		struct Frame {
+			NodeID id;
+			NodeID next;	 // index of the next child to enter
+		};
+		std::vector<Frame> stack;
+
+		auto push = [&](NodeID id) {
+			if constexpr (std::is_same_v<std::invoke_result_t<Enter &, NodeID, std::size_t>, bool>) {
+				if (!enter(id, stack.size())) return;
+			} else enter(id, stack.size());
+			stack.push_back({id, 0});
+		};
+
+		push(from);
+		while (!stack.empty()) {
+			auto &[id, next] = stack.back();
+			if (next < nodes[id].childCount) {
+				push(edges[nodes[id].firstChild + next++]);
+			} else {
+				NodeID done = id;
+				stack.pop_back();
+				leave(done, stack.size());
+			}
+		}
+	}
+
+	template <class Enter, class Leave>
+	void visit(Enter &&enter, Leave &&leave) const {
+		if (!empty()) visit(root(), std::forward<Enter>(enter), std::forward<Leave>(leave));
+	}
+
+	template <class Enter>
+	void visit(Enter &&enter) const {
+		visit(std::forward<Enter>(enter), [](NodeID, std::size_t) {});
+	}
+
+	/// builds the equivalent pointer based tree of a subtree
+	std::unique_ptr<ParseNode<Letter>> toParseNode(NodeID from) const {
+		auto result = std::make_unique<ParseNode<Letter>>(nodes[from].value);
+
+		std::vector<std::pair<NodeID, ParseNode<Letter> *>> stack = {{from, result.get()}};
+		while (!stack.empty()) {
+			auto [id, node] = stack.back();
+			stack.pop_back();
+			node->children.reserve(nodes[id].childCount);
+			for (NodeID child : children(id)) {
+				node->children.push_back(std::make_unique<ParseNode<Letter>>(nodes[child].value));
+				stack.push_back({child, node->children.back().get()});
+			}
+		}
+		return result;
+	}
+
+	std::unique_ptr<ParseNode<Letter>> toParseNode() const { return empty() ? nullptr : toParseNode(root()); }
+};
+
+/**
+ * @brief Receives the events of Parser::parseEvents and Parser::ASTparseEvents. Derive from it and hide the callbacks
+ * you need, they are resolved at compile time.
+ *
+ * @tparam Letter - type of the symbols in the alphabet
+ */
+template <class Letter>
+struct ParseEventHandler {
+	void enter(const Letter) {}		  // a node with children starts
+	void terminal(const Letter) {}	  // a leaf
+	void exit(const Letter) {}		  // the last entered node ends, with its final label
+};
+
+/**
+ * @brief Builds a ParseTree out of parse events
+ */
+template <class Letter>
+class ParseTreeBuilder : public ParseEventHandler<Letter> {
+	using NodeID = typename ParseTree<Letter>::NodeID;
+
+	ParseTree<Letter>		 tree;
+	std::vector<NodeID>		 pending;	  // children of the open nodes
+	std::vector<std::size_t> starts;	  // where the children of each open node start in pending
+
+   public:
+	explicit ParseTreeBuilder(const typename ParseTree<Letter>::allocator_type &alloc = {}) : tree(alloc) {}
+
+	void reserve(std::size_t nodeCount) { tree.reserve(nodeCount, nodeCount); }
+
+	void enter(const Letter) { starts.push_back(pending.size()); }
+	void terminal(const Letter l) { pending.push_back(tree.addLeaf(l)); }
+	void exit(const Letter l) {
+		NodeID id = tree.addNode(l, std::span(pending).subspan(starts.back()));
+		pending.resize(starts.back());
+		pending.push_back(id);
+		starts.pop_back();
+	}
+
+	ParseTree<Letter> take() {
+		pending.clear();
+		starts.clear();
+		return std::move(tree);
+	}
+};
+
+}	  // namespace fl
@@ -1,36 +1,26 @@
 #pragma once
 
 #include <chrono>
+#include <cstdlib>
+#include <filesystem>
 #include <functional>
 #include <memory>
 #include <ratio>
 #include <stack>
 #include <unordered_map>
 
+#include "blob.hpp"
 #include "dpda.h"
 #include "state.hpp"
 #include "utils.h"
 #include "cfg.h"
 #include "formatting.hpp"
 #include "hashing.hpp"
+#include "parse_tree.hpp"
+#include "symbol_table.hpp"
 
 namespace fl {
 
-/**
- * @brief A node in a parse tree
- *
- * @tparam Letter - type of the symbols in the alphabet
- */
-template <class Letter>
-struct ParseNode {
-	Letter											value;
-	std::vector<std::unique_ptr<ParseNode<Letter>>> children;
-
-	ParseNode(const Letter value) : value(value) {}
-	ParseNode(const Letter value, std::vector<std::unique_ptr<ParseNode<Letter>>> &&children)
-		: value(value), children(std::move(children)) {}
-};
-
 /**
  * @brief A custom exception type for errors, emitted while a DPDA is parsing a string
  */
@@ -59,8 +49,23 @@ inline std::size_t getLengthOfTokens(const std::vector<Letter> &word, std::size_
 	return s.size();
 }
 
+/**
+ * @brief Where a parser named name keeps its table between runs: a file in the directory that the environment
+ * variable FL_PARSER_CACHE names, or an empty path, meaning no cache, if it is not set
+ */
+inline std::filesystem::path parserCacheFile(std::string_view name) {
+	const char *directory = std::getenv("FL_PARSER_CACHE");
+	if (directory == nullptr || *directory == '\0') return {};
+	return std::filesystem::path(directory) / std::format("{}.fll1", name);
+}
+
+template <isLetter Letter>
+class IncrementalParser;
+
 template <isLetter Letter>
 class Parser : public DPDA<State<Letter>, Letter> {
+	friend class IncrementalParser<Letter>;
+
    protected:
 	using LState = State<Letter>;
 	using typename DPDA<LState, Letter>::DeltaMap;
@@ -70,9 +75,212 @@ class Parser : public DPDA<State<Letter>, Letter> {
 
 	CFG<Letter> g;
 
-	const fl::unordered_map<Letter, bool>					   nullable;
-	const fl::unordered_map<Letter, fl::unordered_set<Letter>> first;
-	const fl::unordered_map<Letter, fl::unordered_set<Letter>> follow;
+	// only needed to build the table and to explain mistakes, so a parser loaded from a blob computes them on demand
+	mutable fl::unordered_map<Letter, bool>						 nullable;
+	mutable fl::unordered_map<Letter, fl::unordered_set<Letter>> first;
+	mutable fl::unordered_map<Letter, fl::unordered_set<Letter>> follow;
+	mutable bool												 setsReady = false;
+
+	void computeSets() const {
+		if (setsReady) return;
+		std::tie(nullable, first, follow) = g.findSets();
+		setsReady						  = true;
+	}
+
+	// the same automaton compiled to a dense LL(1) table over the symbols of the grammar
+	using Symbol = typename SymbolTable<Letter>::Symbol;
+	struct TableRule {
+		Letter								  lhs;
+		typename CFG<Letter>::Production	  production;
+		typename CFG<Letter>::NonTerminalData data;
+		std::uint32_t						  rhs;	   // start of the right side, reversed, in rhsSymbols
+	};
+	static constexpr std::uint32_t noRule = -1;
+
+	/// the rules a parse applies, in the order it expands them
+	using ProductionVector = std::vector<std::reference_wrapper<const TableRule>>;
+
+	SymbolTable<Letter>		   symbols;
+	Symbol					   startSymbol = 0;
+	std::vector<TableRule>	   rules;
+	std::vector<Symbol>		   rhsSymbols;
+	std::vector<std::uint32_t> table;	  // [non-terminal - terminalCount][terminal] -> index in rules
+
+	Symbol symbolOf(const Letter l) const {
+		Symbol s = symbols.find(l);
+		if (s == SymbolTable<Letter>::none) {
+			throw std::runtime_error(std::format("'{}' is neither a terminal nor a non-terminal", l));
+		}
+		return s;
+	}
+
+	void internSymbols() {
+		symbols		= SymbolTable<Letter>(g);
+		startSymbol = symbolOf(g.start);
+		table.assign(symbols.nonTerminalCount() * symbols.terminalCount(), noRule);
+	}
+
+	void addTableRule(const Letter A, const typename CFG<Letter>::Production &v,
+					  const fl::unordered_set<Letter> &lookaheads) {
+		auto NTData = g.nonTerminalData.find(A);
+		rules.push_back({A, v,
+						 NTData != g.nonTerminalData.end() ? NTData->second : typename CFG<Letter>::NonTerminalData{},
+						 std::uint32_t(rhsSymbols.size())});
+		for (const auto l : v.rhs | std::views::reverse) {
+			rhsSymbols.push_back(symbolOf(l));
+		}
+		const std::size_t T	  = symbols.terminalCount();
+		std::uint32_t	 *row = table.data() + (symbolOf(A) - T) * T;
+		// on a conflict the first rule stays, like the transition the DPDA keeps
+		for (const auto l : lookaheads) {
+			if (row[symbolOf(l)] == noRule) row[symbolOf(l)] = rules.size() - 1;
+		}
+	}
+
+	static constexpr std::uint32_t blobMagic   = 0x314c4c46;	 // "FLL1"
+	static constexpr std::uint32_t blobVersion = 1;
+
+	void build() {
+		bool intersection = false;
+		for (const auto l : g.terminals) {
+			if (g.nonTerminals.contains(l)) {
+				intersection = true;
+				break;
+			}
+		}
+		for (const auto l : g.nonTerminals) {
+			if (g.terminals.contains(l)) {
+				intersection = true;
+				break;
+			}
+		}
+		if (intersection) {
+			throw std::runtime_error("Grammar is not LL(1): intersection between terminals and nonterminals");
+		}
+
+		computeSets();
+		addTransition(0, Letter::eps, Letter::eps, 1, {g.start});
+
+		auto f = [](const Letter l) -> LState { return Letter::size + std::size_t(l); };
+
+		try {
+			internSymbols();
+			for (const auto &[A, v] : g.rules) {
+				if (v.empty()) {
+					const auto &followA = follow.find(A)->second;
+					for (const auto l : followA) {
+						addTransition(f(l), Letter::eps, A, f(l), v);
+					}
+					addTableRule(A, v, followA);
+				} else {
+					const auto &firstA = g.first(v.rhs, nullable, first);
+					for (const auto l : firstA) {
+						addTransition(f(l), Letter::eps, A, f(l), v);
+					}
+					addTableRule(A, v, firstA);
+				}
+			}
+
+			for (const auto l : g.terminals) {
+				addTransition(1, l, Letter::eps, f(l), {});
+				if (l != g.eof) addTransition(f(l), Letter::eps, l, 1, {});
+			}
+		} catch (...) { std::throw_with_nested(std::runtime_error("Failed to create parser for grammar")); }
+
+		qFinal = f(g.eof);
+	}
+
+	/**
+	 * @brief Loads what save() wrote, checking every index in it, and rebuilds the transitions of the DPDA from the
+	 * table. Leaves the parser untouched and returns false if the blob is damaged or belongs to another grammar
+	 */
+	bool load(std::span<const std::byte> blob) {
+		BlobReader in(blob);
+		if (in.read<std::uint32_t>() != blobMagic || in.read<std::uint32_t>() != blobVersion ||
+			in.read<std::uint64_t>() != fingerprint(g)) {
+			return false;
+		}
+
+		const auto			letters		  = in.readVector<std::uint64_t>();
+		const auto			terminalCount = in.read<std::uint64_t>();
+		const Symbol		start		  = in.read<Symbol>();
+		SymbolTable<Letter> loadedSymbols(
+			letters | std::views::take(std::min<std::uint64_t>(terminalCount, letters.size())) |
+			std::views::transform([](const std::uint64_t l) { return Letter(std::size_t(l)); }));
+		for (const auto l : letters | std::views::drop(loadedSymbols.size())) {
+			loadedSymbols.add(Letter(std::size_t(l)));
+		}
+		if (!in.ok() || loadedSymbols.size() != letters.size() || loadedSymbols.terminalCount() != terminalCount ||
+			start < terminalCount || start >= letters.size() || loadedSymbols.letter(start) != g.start) {
+			return false;
+		}
+
+		auto loadedRhs = in.readVector<Symbol>();
+		for (const Symbol s : loadedRhs) {
+			if (s >= letters.size()) return false;
+		}
+
+		std::vector<TableRule> loadedRules;
+		const auto			   ruleCount = in.read<std::uint64_t>();
+		for (std::uint64_t i = 0; i < ruleCount && in.ok(); ++i) {
+			const Symbol						  lhs		  = in.read<Symbol>();
+			const Letter						  replaceWith = Letter(std::size_t(in.read<std::uint64_t>()));
+			const auto							  ignore	  = in.readVector<std::uint8_t>();
+			typename CFG<Letter>::NonTerminalData data;
+			data.upwardSpillThreshold			  = in.read<std::int32_t>();
+			data.ignoreEmpty					  = in.read<std::uint8_t>();
+			data.ignoreSingleChild				  = in.read<std::uint8_t>();
+			const std::uint32_t					  rhs		  = in.read<std::uint32_t>();
+			const std::uint32_t					  length	  = in.read<std::uint32_t>();
+			if (lhs < terminalCount || lhs >= letters.size() || rhs > loadedRhs.size() ||
+				length > loadedRhs.size() - rhs) {
+				return false;
+			}
+
+			std::vector<Letter> production;
+			for (std::uint32_t j = length; j-- > 0;) {
+				production.push_back(loadedSymbols.letter(loadedRhs[rhs + j]));
+			}
+			loadedRules.push_back({loadedSymbols.letter(lhs),
+								   {std::move(production), std::vector<bool>(ignore.begin(), ignore.end()), replaceWith},
+								   data,
+								   rhs});
+		}
+
+		auto loadedTable = in.readVector<std::uint32_t>();
+		if (!in.ok() || !in.atEnd() || loadedTable.size() != loadedSymbols.nonTerminalCount() * terminalCount) {
+			return false;
+		}
+		for (const auto r : loadedTable) {
+			if (r != noRule && r >= loadedRules.size()) return false;
+		}
+
+		symbols		= std::move(loadedSymbols);
+		startSymbol = start;
+		rules		= std::move(loadedRules);
+		rhsSymbols	= std::move(loadedRhs);
+		table		= std::move(loadedTable);
+
+		// the DPDA still backs generateProductions and the error messages, so it gets the same transitions back
+		auto f = [](const Letter l) -> LState { return Letter::size + std::size_t(l); };
+		addTransition(0, Letter::eps, Letter::eps, 1, {g.start});
+		const std::size_t T = terminalCount;
+		for (std::size_t A = T; A < symbols.size(); ++A) {
+			for (Symbol t = 0; t < T; ++t) {
+				const auto r = table[(A - T) * T + t];
+				if (r == noRule) continue;
+				const Letter l = symbols.letter(t);
+				addTransition(f(l), Letter::eps, symbols.letter(A), f(l), rules[r].production);
+			}
+		}
+		for (Symbol t = 0; t < T; ++t) {
+			const Letter l = symbols.letter(t);
+			addTransition(1, l, Letter::eps, f(l), {});
+			if (l != g.eof) addTransition(f(l), Letter::eps, l, 1, {});
+		}
+		qFinal = f(g.eof);
+		return true;
+	}
 
 	void detectMistake(const std::vector<Letter> &word, std::size_t offset, const std::vector<Letter> &stack,
 					   LState current_state) const {
@@ -87,6 +295,7 @@ class Parser : public DPDA<State<Letter>, Letter> {
 		if (current_state == 1 && !g.terminals.contains(word[offset])) {
 			msg = std::format("unexpected '{}' - not a valid terminal", word[offset]);
 		} else if (!stack.empty() && current_state > Letter::size) {
+			computeSets();
 			fl::unordered_set<Letter> expected;
 			auto					  &firsts = *this->first.find(stack.back());
 			expected						  = firsts.second;
@@ -129,63 +338,103 @@ class Parser : public DPDA<State<Letter>, Letter> {
 	using DPDA<LState, Letter>::enable_print;
 	using DPDA<LState, Letter>::printTransitions;
 
-	const auto &getFirst() const { return first; }
-	const auto &getFollow() const { return follow; }
-	const auto &getNullable() const { return nullable; }
+	const auto &getFirst() const { return computeSets(), first; }
+	const auto &getFollow() const { return computeSets(), follow; }
+	const auto &getNullable() const { return computeSets(), nullable; }
 
 	/**
 	 * @brief Construct a Parser from an LL(1) grammar. Throws if grammar is not LL(1)
 	 *
 	 * @param grammar
 	 */
-	Parser(const CFG<Letter> &grammar)
-		: g(grammar),
-		  nullable(grammar.findNullables()),
-		  first(grammar.findFirsts(nullable)),
-		  follow(grammar.findFollows(nullable, first)) {
-		bool intersection = false;
+	Parser(const CFG<Letter> &grammar) : g(grammar) { build(); }
+
+	/**
+	 * @brief Construct a Parser from a blob made by save(), without computing the FIRST and FOLLOW sets of the
+	 * grammar. Throws if the blob is damaged or was saved for a different grammar
+	 *
+	 * @param grammar - the grammar the blob was saved for
+	 * @param blob
+	 */
+	Parser(const CFG<Letter> &grammar, std::span<const std::byte> blob) : g(grammar) {
+		if (!load(blob)) throw std::runtime_error("Parse table blob is damaged or was saved for a different grammar");
+	}
+
+	/**
+	 * @brief Construct a Parser from the blob in a cache file if it is there and still matches the grammar, otherwise
+	 * build it and try to save it there for the next run. An empty path only builds the parser
+	 *
+	 * @param grammar
+	 * @param cache - e.g. parserCacheFile("name")
+	 */
+	Parser(const CFG<Letter> &grammar, const std::filesystem::path &cache) : g(grammar) {
+		if (!cache.empty() && load(readBlob(cache))) return;
+		build();
+		if (!cache.empty() && !writeBlob(cache, save())) {
+			dbLog(dbg::LOG_WARNING, std::format("could not save parse table to {}", cache.string()));
+		}
+	}
+
+	/**
+	 * @brief Identifies a grammar by its terminals, non-terminals, rules and AST data, so a saved table is not loaded
+	 * for a grammar that has changed since. The order of the rules and sets in the grammar does not matter
+	 */
+	static std::uint64_t fingerprint(const CFG<Letter> &grammar) {
+		auto		code = [](const Letter l) -> std::size_t { return std::size_t(l); };
+		std::size_t sum	 = 0;
 		for (const auto l : grammar.terminals) {
-			if (grammar.nonTerminals.contains(l)) {
-				intersection = true;
-				break;
-			}
+			sum += hashCombine(1, code(l));
 		}
 		for (const auto l : grammar.nonTerminals) {
-			if (grammar.terminals.contains(l)) {
-				intersection = true;
-				break;
+			sum += hashCombine(2, code(l));
+		}
+		for (const auto &[A, v] : grammar.rules) {
+			std::size_t h = hashCombine(code(A), code(v.replaceWith));
+			for (std::size_t i = 0; i < v.size(); ++i) {
+				h = hashCombine(h, code(v[i]) * 2 + (i < v.ignore.size() && v.ignore[i]));
 			}
+			sum += hashCombine(3, h);
 		}
-		if (intersection) {
-			throw std::runtime_error("Grammar is not LL(1): intersection between terminals and nonterminals");
+		for (const auto &[A, data] : grammar.nonTerminalData) {
+			sum += hashCombine(hashCombine(4, code(A)), hashCombine(std::size_t(data.upwardSpillThreshold),
+																	 data.ignoreEmpty * 2 + data.ignoreSingleChild));
 		}
+		return hashCombine(hashCombine(hashCombine(blobVersion, code(grammar.start)), code(grammar.eof)), sum);
+	}
 
-		addTransition(0, Letter::eps, Letter::eps, 1, {grammar.start});
-
-		auto f = [](const Letter l) -> LState { return Letter::size + std::size_t(l); };
-
-		try {
-			for (const auto &[A, v] : grammar.rules) {
-				if (v.empty()) {
-					const auto &followA = follow.find(A)->second;
-					for (const auto l : followA) {
-						addTransition(f(l), Letter::eps, A, f(l), v);
-					}
-				} else {
-					const auto &firstA = grammar.first(v.rhs, nullable, first);
-					for (const auto l : firstA) {
-						addTransition(f(l), Letter::eps, A, f(l), v);
-					}
-				}
-			}
-
-			for (const auto l : grammar.terminals) {
-				addTransition(1, l, Letter::eps, f(l), {});
-				if (l != grammar.eof) addTransition(f(l), Letter::eps, l, 1, {});
-			}
-		} catch (...) { std::throw_with_nested(std::runtime_error("Failed to create parser for grammar")); }
-
-		qFinal = f(grammar.eof);
+	/**
+	 * @brief Saves the symbols, the LL(1) table and the productions with their AST data into a blob, which
+	 * Parser(grammar, blob) loads in time linear in its size. The blob is in the byte order of the machine
+	 */
+	std::vector<std::byte> save() const {
+		BlobWriter out;
+		out.write(blobMagic);
+		out.write(blobVersion);
+		out.write(fingerprint(g));
+
+		std::vector<std::uint64_t> letters;
+		for (const Letter l : symbols) {
+			letters.push_back(std::size_t(l));
+		}
+		out.writeVector(std::span<const std::uint64_t>(letters));
+		out.write(std::uint64_t(symbols.terminalCount()));
+		out.write(startSymbol);
+		out.writeVector(std::span<const Symbol>(rhsSymbols));
+
+		out.write(std::uint64_t(rules.size()));
+		for (const auto &rule : rules) {
+			std::vector<std::uint8_t> ignore(rule.production.ignore.begin(), rule.production.ignore.end());
+			out.write(symbols.find(rule.lhs));
+			out.write(std::uint64_t(std::size_t(rule.production.replaceWith)));
+			out.writeVector(std::span<const std::uint8_t>(ignore));
+			out.write(std::int32_t(rule.data.upwardSpillThreshold));
+			out.write(std::uint8_t(rule.data.ignoreEmpty));
+			out.write(std::uint8_t(rule.data.ignoreSingleChild));
+			out.write(rule.rhs);
+			out.write(std::uint32_t(rule.production.size()));
+		}
+		out.writeVector(std::span<const std::uint32_t>(table));
+		return out.take();
 	}
 
 	/**
@@ -195,9 +444,8 @@ class Parser : public DPDA<State<Letter>, Letter> {
 	 * @param word
 	 * @return requires&&
 	 */
-	std::unique_ptr<ParseNode<Letter>> makeParseTree(
-		const std::vector<std::reference_wrapper<const typename DeltaMap::value_type>> &productions,
-		const std::vector<Letter>													   &word) const {
+	std::unique_ptr<ParseNode<Letter>> makeParseTree(const ProductionVector	 &productions,
+													 const std::vector<Letter> &word) const {
 		// stack implementation
 		struct ParsingState {
 			std::unique_ptr<ParseNode<Letter>> node;
@@ -212,8 +460,7 @@ class Parser : public DPDA<State<Letter>, Letter> {
 
 		while (word_position < word.size()) {
 			auto &[topNode, idx, prod_index] = parseStack.top();
-			const auto &[from, to]			 = productions[prod_index].get();
-			const auto &[_, product]		 = to;
+			const auto &product				 = productions[prod_index].get().production;
 
 			if (idx == product.size()) {
 				if (product.empty()) topNode->children.push_back(std::make_unique<ParseNode<Letter>>(Letter::eps));
@@ -241,9 +488,8 @@ class Parser : public DPDA<State<Letter>, Letter> {
 		return std::move(parseStack.top().node);
 	}
 
-	std::unique_ptr<ParseNode<Letter>> makeAST(
-		const std::vector<std::reference_wrapper<const typename DeltaMap::value_type>> &productions,
-		const std::vector<Letter>													   &word) const {
+	std::unique_ptr<ParseNode<Letter>> makeAST(const ProductionVector	&productions,
+											   const std::vector<Letter> &word) const {
 		// stack implementation
 		struct ParsingState {
 			std::unique_ptr<ParseNode<Letter>> node;
@@ -258,9 +504,7 @@ class Parser : public DPDA<State<Letter>, Letter> {
 
 		while (word_position < word.size()) {
 			auto &[topNode, idx, prod_index] = parseStack.top();
-			const auto &[from, to]			 = productions[prod_index].get();
-			const auto &[_, _, A]			 = from;
-			const auto &[_, product]		 = to;
+			const auto &[A, product, _, _]	 = productions[prod_index].get();
 
 			if (idx == product.size()) {
 				if (parseStack.size() == 1) break;
@@ -311,14 +555,16 @@ class Parser : public DPDA<State<Letter>, Letter> {
 		return std::move(parseStack.top().node);
 	}
 
-	using ProductionVector = std::vector<std::reference_wrapper<const typename DeltaMap::value_type>>;
-
-	std::pair<bool, ProductionVector> generateProductions(const std::vector<Letter> &word) const {
-		std::size_t																 offset = 0;
-		std::vector<Letter>														 stack;
-		LState																	 current_state = 0;
-		typename DeltaMap::const_iterator										 res		   = delta.begin();
-		std::vector<std::reference_wrapper<const typename DeltaMap::value_type>> productions;
+	/**
+	 * @brief Runs the DPDA on a word and calls step(transition, stack, offset) after every transition it takes. If the
+	 * word is rejected, throws a ParseError
+	 */
+	template <class Step>
+	bool runAutomaton(const std::vector<Letter> &word, Step &&step) const {
+		std::size_t						  offset = 0;
+		std::vector<Letter>				  stack;
+		LState							  current_state = 0;
+		typename DeltaMap::const_iterator res			= delta.begin();
 
 		while ((current_state != qFinal || !stack.empty()) && res != delta.end()) {
 			const Letter &l = offset < word.size() ? word[offset] : Letter::eps;
@@ -336,17 +582,379 @@ class Parser : public DPDA<State<Letter>, Letter> {
 				res = transition(current_state, Letter::eps, Letter::eps, stack, offset);
 			}
 
-			if (res != delta.end() && std::get<0>(res->first) == std::get<0>(res->second))
-				productions.push_back(std::ref(*res));
+			if (res != delta.end()) step(*res, stack, offset);
 		}
 		if (enable_print) { printState(current_state, offset, stack, word); }
 
 		bool accepted = current_state == qFinal && stack.empty() && offset == word.size();
 
 		if (!accepted) { detectMistake(word, offset, stack, current_state); }
+		return accepted;
+	}
+
+	/// where and why runTable stopped
+	struct TableResult {
+		bool		accepted;
+		std::size_t offset;		// tokens read
+		Symbol		top;		// top of the stack, none if it is empty
+		Letter		got;		// the lookahead, eof at the end of the input
+		bool		atEnd;		// whether the input was over
+	};
+
+	/**
+	 * @brief Runs the LL(1) table on the tokens in [it, end) with an integer stack, reading each token once. Calls
+	 * expand(rule, lookahead, stackSize) after a non-terminal is replaced by the right side of rule and
+	 * match(token, stackSize) after a terminal is matched. The input has to end with eof, unless implicitEof is set,
+	 * in which case the end of the input counts as one. Stops at the first error, without reporting it
+	 */
+	template <std::input_iterator It, std::sentinel_for<It> End, class Proj, class Expand, class Match>
+	TableResult runTable(It it, End end, Proj &&proj, bool implicitEof, Expand &&expand, Match &&match) const {
+		constexpr Symbol  noSymbol = SymbolTable<Letter>::none;
+		const std::size_t T		   = symbols.terminalCount();
+		const Symbol	  eof	   = symbols.find(g.eof);
+
+		std::size_t offset	= 0;
+		Letter		current = g.eof;
+		Symbol		a		= noSymbol;
+
+		// reads the lookahead, without advancing
+		auto read = [&]() {
+			if (it == end) {
+				current = g.eof;
+				a		= implicitEof ? eof : noSymbol;
+				return;
+			}
+			current	 = std::invoke(proj, *it);
+			Symbol s = symbols.find(current);
+			a		 = s < T ? s : noSymbol;
+		};
+		auto stop = [&](Symbol top) { return TableResult{false, offset, top, current, it == end}; };
+
+		std::vector<Symbol> stack = {startSymbol};
+		read();
+		while (!stack.empty()) {
+			const Symbol top = stack.back();
+			if (top < T) {
+				if (top != a || it == end) return stop(top);
+				stack.pop_back();
+				match(current, stack.size());
+				++it;
+				++offset;
+				read();
+			} else {
+				if (a == noSymbol) return stop(top);
+				const std::uint32_t r = table[(top - T) * T + a];
+				if (r == noRule) return stop(top);
+				const TableRule &rule = rules[r];
+				const auto		 rhs  = rhsSymbols.begin() + rule.rhs;
+				stack.pop_back();
+				stack.insert(stack.end(), rhs, rhs + rule.production.size());
+				expand(rule, current, stack.size());
+			}
+		}
+		if (a != eof) return stop(noSymbol);
+		if (it != end) {	 // the eof token itself
+			++it;
+			++offset;
+			if (it != end) {
+				read();
+				return stop(noSymbol);
+			}
+		}
+		return TableResult{true, offset, noSymbol, g.eof, true};
+	}
+
+	/**
+	 * @brief Runs the table, and if it rejects the word, the DPDA, which throws a ParseError that points at the
+	 * mistake. With enable_print the DPDA runs first to print its steps
+	 */
+	template <class Expand, class Match>
+	bool run(const std::vector<Letter> &word, Expand &&expand, Match &&match) const {
+		auto ignore = [](auto &&...) {};
+		if (enable_print) runAutomaton(word, ignore);
+		if (runTable(word.begin(), word.end(), std::identity{}, false, expand, match).accepted) return true;
+		return runAutomaton(word, ignore);
+	}
+
+	/**
+	 * @brief Runs the table on a stream of tokens that is read only once, so a rejected input can not be replayed on
+	 * the DPDA. Throws a ParseError built from where the table stopped instead
+	 */
+	template <std::ranges::input_range Input, class Proj, class Expand, class Match>
+	bool runStream(Input &&input, Proj &&proj, Expand &&expand, Match &&match) const {
+		auto result = runTable(std::ranges::begin(input), std::ranges::end(input), proj, true, expand, match);
+		if (result.accepted) return true;
+
+		auto got = [&]() -> std::string {
+			return result.atEnd ? std::string("end of file") : std::format("'{}'", result.got);
+		};
+		std::string msg;
+		if (result.top == SymbolTable<Letter>::none) {
+			msg = std::format("expected end of file, but got {}", got());
+		} else if (!result.atEnd && !g.terminals.contains(result.got)) {
+			msg = std::format("unexpected '{}' - not a valid terminal", result.got);
+		} else if (symbols.isTerminal(result.top)) {
+			msg = std::format("expected '{}', but got {}", symbols.letter(result.top), got());
+		} else {
+			const std::size_t T = symbols.terminalCount();
+			for (Symbol t = 0; t < T; ++t) {
+				if (table[(result.top - T) * T + t] == noRule) continue;
+				msg += std::format("{}'{}'", msg.empty() ? "" : ", ", symbols.letter(t));
+			}
+			msg = std::format("expected one of [{}], but got {}", msg, got());
+		}
+		throw ParseError(msg, result.offset);
+	}
+
+	/**
+	 * @brief Same as DPDA::recognize, but runs the LL(1) table
+	 *
+	 * @param word
+	 * @return whether the word is in the language of the grammar
+	 */
+	bool recognize(const std::vector<Letter> &word) const {
+		if (enable_print) return DPDA<LState, Letter>::recognize(word);
+		return runTable(word.begin(), word.end(), std::identity{}, false, [](auto &&...) {}, [](auto &&...) {})
+			.accepted;
+	}
+
+	template <typename U = Letter>
+		requires std::is_constructible_v<Letter, char>
+	bool recognize(const std::string &word) const {
+		return recognize(std::vector<Letter>(word.begin(), word.end()));
+	}
+
+	/**
+	 * @brief Recognizes a stream of tokens, e.g. a LexerRange, reading it once. The end of the input counts as eof and
+	 * the memory used is bounded by the depth of the parse stack, not by the length of the input
+	 *
+	 * @param input - an input range of tokens
+	 * @param proj - turns an element of input into a Letter
+	 * @return whether the tokens form a word in the language of the grammar
+	 */
+	template <std::ranges::input_range Input, class Proj = std::identity>
+		requires(!std::convertible_to<Input, const std::vector<Letter> &> &&
+				 !std::convertible_to<Input, const std::string &>)
+	bool recognize(Input &&input, Proj proj = {}) const {
+		return runTable(std::ranges::begin(input), std::ranges::end(input), proj, true, [](auto &&...) {},
+						[](auto &&...) {})
+			.accepted;
+	}
+
+	std::pair<bool, ProductionVector> generateProductions(const std::vector<Letter> &word) const {
+		ProductionVector productions;
+		bool			 accepted = run(
+			word,
+			[&](const TableRule &rule, const Letter, std::size_t) { productions.push_back(std::cref(rule)); },
+			[](const Letter, std::size_t) {});
 		return {accepted, productions};
 	}
 
+	/**
+	 * @brief Reports the parse tree as events to handler, while drive(expand, match) runs the table
+	 */
+	template <class Handler, class Drive>
+	bool emitEvents(Handler &handler, Drive &&drive) const {
+		struct OpenNode {
+			Letter		value;
+			std::size_t height;		// size of the stack without the right side of its production
+		};
+		std::vector<OpenNode> open;
+
+		auto close = [&](std::size_t stackSize) {
+			while (!open.empty() && open.back().height == stackSize) {
+				handler.exit(open.back().value);
+				open.pop_back();
+			}
+		};
+		return drive(
+			[&](const TableRule &rule, const Letter, std::size_t stackSize) {
+				handler.enter(rule.lhs);
+				if (rule.production.empty()) handler.terminal(Letter::eps);
+				open.push_back({rule.lhs, stackSize - rule.production.size()});
+				close(stackSize);
+			},
+			[&](const Letter l, std::size_t stackSize) {
+				handler.terminal(l);
+				close(stackSize);
+			});
+	}
+
+	/**
+	 * @brief Parses a word in a single pass and reports its parse tree as events while it runs: enter(A) when A
+	 * is expanded, terminal(a) when a is matched and exit(A) when the last symbol A was expanded to is done. Empty
+	 * productions give an eps leaf, like in makeParseTree. Neither the productions nor the tree are stored. If it
+	 * fails, throws a ParseError
+	 *
+	 * @param word
+	 * @param handler - a ParseEventHandler
+	 * @return whether the word was accepted
+	 */
+	template <class Handler>
+	bool parseEvents(const std::vector<Letter> &word, Handler &&handler) const {
+		return emitEvents(handler, [&](auto &&expand, auto &&match) { return run(word, expand, match); });
+	}
+
+	/**
+	 * @brief Same as the other method, but reads a stream of tokens once, like recognize does. Besides the parse
+	 * stack, it keeps one entry for every node that is still open
+	 *
+	 * @param input - an input range of tokens
+	 * @param handler - a ParseEventHandler
+	 * @param proj - turns an element of input into a Letter
+	 */
+	template <std::ranges::input_range Input, class Handler, class Proj = std::identity>
+		requires(!std::convertible_to<Input, const std::vector<Letter> &>)
+	bool parseEvents(Input &&input, Handler &&handler, Proj proj = {}) const {
+		return emitEvents(handler, [&](auto &&expand, auto &&match) { return runStream(input, proj, expand, match); });
+	}
+
+	/**
+	 * @brief Same as parseEvents, but reports the AST that makeAST would build. The ignore, replaceWith, ignoreEmpty,
+	 * ignoreSingleChild and upwardSpillThreshold rules are applied inline. A node those rules could still remove is
+	 * held back, together with the events under it, until it has enough children to stay or ends. Everything else goes
+	 * straight to the handler. A single child that is thrown out may rename its parent after the parent was entered;
+	 * exit always receives the final label.
+	 *
+	 * @param word
+	 * @param handler - a ParseEventHandler
+	 * @return whether the word was accepted
+	 */
+	template <class Handler>
+	bool ASTparseEvents(const std::vector<Letter> &word, Handler &&handler) const {
+		return emitASTEvents(handler, [&](auto &&expand, auto &&match) { return run(word, expand, match); });
+	}
+
+	template <std::ranges::input_range Input, class Handler, class Proj = std::identity>
+		requires(!std::convertible_to<Input, const std::vector<Letter> &>)
+	bool ASTparseEvents(Input &&input, Handler &&handler, Proj proj = {}) const {
+		return emitASTEvents(handler,
+							 [&](auto &&expand, auto &&match) { return runStream(input, proj, expand, match); });
+	}
+
+	/**
+	 * @brief Reports the AST as events to handler, while drive(expand, match) runs the table
+	 */
+	template <class Handler, class Drive>
+	bool emitASTEvents(Handler &handler, Drive &&drive) const {
+		using NTData	 = typename CFG<Letter>::NonTerminalData;
+		using Production = typename CFG<Letter>::Production;
+		enum class Event : std::uint8_t { None, Enter, Terminal, Exit };
+		static constexpr std::size_t committed = -1;
+
+		struct OpenNode {
+			Letter			  value;
+			const Production *product;
+			const NTData	 *data;
+			std::size_t		  height;	   // size of the stack without the right side of product
+			std::size_t		  held;		   // index of its enter event in held, unless committed
+			unsigned int	  idx;		   // symbols of product that are done
+			unsigned int	  children;	   // children in the AST so far
+
+			Letter label() const { return product->replaceWith != Letter::eps ? product->replaceWith : value; }
+		};
+		std::vector<OpenNode>				  open;
+		std::vector<std::pair<Event, Letter>> held;	   // events below a node that may still be removed
+		std::size_t							  uncommitted = 0;
+
+		auto dispatch = [&](Event e, const Letter l) {
+			switch (e) {
+				case Event::Enter: handler.enter(l); break;
+				case Event::Terminal: handler.terminal(l); break;
+				case Event::Exit: handler.exit(l); break;
+				case Event::None: break;
+			}
+		};
+		auto send = [&](Event e, const Letter l) {
+			if (uncommitted) held.push_back({e, l});
+			else dispatch(e, l);
+		};
+		auto release = [&]() {
+			if (--uncommitted) return;
+			for (const auto &[e, l] : held) {
+				dispatch(e, l);
+			}
+			held.clear();
+		};
+		// from this many children on, the rules keep the node whatever comes next
+		auto keepsFrom = [](const NTData &d) -> unsigned int {
+			unsigned int n = d.ignoreSingleChild ? 2 : d.ignoreEmpty ? 1 : 0;
+			return d.upwardSpillThreshold < 0 ? n : std::max(n, unsigned(d.upwardSpillThreshold) + 1);
+		};
+		auto addChildren = [&](OpenNode &node, unsigned int n) {
+			node.children += n;
+			if (node.held != committed && node.children >= keepsFrom(*node.data)) {
+				held[node.held] = {Event::Enter, node.label()};
+				node.held		= committed;
+				release();
+			}
+		};
+		auto close = [&]() {
+			OpenNode node = open.back();
+			open.pop_back();
+			if (open.empty()) {		// the root is kept as it is
+				send(Event::Exit, node.value);
+				return;
+			}
+			auto &parent = open.back();
+			++parent.idx;
+			if (node.held == committed) {
+				send(Event::Exit, node.label());
+				addChildren(parent, 1);
+				return;
+			}
+
+			const NTData &data = *node.data;
+			if (data.ignoreEmpty && node.children == 0) {
+				held.resize(node.held);
+			} else if (data.ignoreSingleChild && node.children == 1) {
+				held[node.held].first = Event::None;
+				if (node.product->replaceWith != Letter::eps) { parent.value = node.product->replaceWith; }
+				addChildren(parent, 1);
+			} else if (data.upwardSpillThreshold < 0 || node.children > unsigned(data.upwardSpillThreshold)) {
+				held[node.held] = {Event::Enter, node.label()};
+				held.push_back({Event::Exit, node.label()});
+				addChildren(parent, 1);
+			} else {	 // spill upwards if we have few children
+				held[node.held].first = Event::None;
+				addChildren(parent, node.children);
+			}
+			release();
+		};
+
+		auto closeAll = [&](std::size_t stackSize) {
+			while (!open.empty() && open.back().height == stackSize) {
+				close();
+			}
+		};
+
+		return drive(
+			[&](const TableRule &rule, const Letter, std::size_t stackSize) {
+				const std::size_t height = stackSize - rule.production.size();
+				OpenNode		  node{rule.lhs, &rule.production, &rule.data, height, committed, 0, 0};
+				if (open.empty()) {
+					send(Event::Enter, rule.lhs);
+				} else if (keepsFrom(rule.data) == 0) {
+					send(Event::Enter, node.label());
+				} else {
+					node.held = held.size();
+					held.push_back({Event::None, rule.lhs});
+					++uncommitted;
+				}
+				open.push_back(node);
+				closeAll(stackSize);
+			},
+			[&](const Letter l, std::size_t stackSize) {
+				auto &parent = open.back();
+				if (!parent.product->ignore[parent.idx]) {
+					send(Event::Terminal, l);
+					addChildren(parent, 1);
+				}
+				++parent.idx;
+				closeAll(stackSize);
+			});
+	}
+
 	/**
 	 * @brief parses a word and builds its parse tree. If it fails, throws a ParseError
 	 *
@@ -379,6 +987,29 @@ class Parser : public DPDA<State<Letter>, Letter> {
 		return parseTree;
 	}
 
+	/**
+	 * @brief parses a word and builds its flat parse tree. If it fails, throws a ParseError
+	 *
+	 * @param word
+	 * @param alloc - memory for the tree, e.g. a monotonic_buffer_resource that is released with it
+	 * @return ParseTree<Letter>
+	 */
+	ParseTree<Letter> parseFlat(const std::vector<Letter>						&word,
+								const typename ParseTree<Letter>::allocator_type &alloc = {}) const {
+		ParseTreeBuilder<Letter> builder(alloc);
+		builder.reserve(2 * word.size());
+		if (!parseEvents(word, builder)) { return ParseTree<Letter>(alloc); }
+		return builder.take();
+	}
+
+	ParseTree<Letter> ASTparseFlat(const std::vector<Letter>						  &word,
+								   const typename ParseTree<Letter>::allocator_type &alloc = {}) const {
+		ParseTreeBuilder<Letter> builder(alloc);
+		builder.reserve(word.size());
+		if (!ASTparseEvents(word, builder)) { return ParseTree<Letter>(alloc); }
+		return builder.take();
+	}
+
 	/**
 	 * @brief same as the other method, but for strings
 	 *
@@ -449,6 +1080,20 @@ static void p_show(std::ostream &out, const Node *r, bits &b,
 		}
 	} else out << " \u25cb" << std::endl;	  // ○
 }
+
+template <class Letter>
+static void p_show(std::ostream &out, const ParseTree<Letter> &t, typename ParseTree<Letter>::NodeID id, bits &b) {
+	out << "-" << t.value(id) << std::endl;
+	auto children = t.children(id);
+	for (size_t i = 0; i < children.size(); ++i) {
+		bool last = i + 1 == children.size();
+		p_tabs(out, b);
+		out << (last ? " \u2514" : " \u251c");	 // └ or ├
+		b.push_back(!last);
+		p_show(out, t, children[i], b);
+		b.pop_back();
+	}
+}
 }	  // namespace
 
 template <class Letter>
@@ -457,6 +1102,14 @@ std::ostream &operator<<(std::ostream &out, const std::unique_ptr<ParseNode<Lett
 	p_show<ParseNode<Letter>>(out, node.get(), b, printFunctionDefault<Letter>);
 	return out;
 }
+
+template <class Letter>
+std::ostream &operator<<(std::ostream &out, const ParseTree<Letter> &tree) {
+	bits b;
+	if (tree.empty()) out << " \u25cb" << std::endl;	  // ○
+	else p_show(out, tree, tree.root(), b);
+	return out;
+}
 }	  // namespace fl
 
 template <fl::isLetter Letter>
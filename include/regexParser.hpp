@@ -41,13 +41,12 @@ fl::CFG<Token> createRegexGrammar();
 
 class RegexParser : public fl::Parser<fl::Token> {
    public:
-	RegexParser() : Parser<Token>(createRegexGrammar()) {}
+	RegexParser() : Parser<Token>(createRegexGrammar(), fl::parserCacheFile("regex")) {}
 
-	std::unique_ptr<ParseNode<Token>> makeParseTree(
-		const std::vector<std::reference_wrapper<const Parser<Token>::DeltaMap::value_type>> &productions,
-		const std::vector<Token> &word, int &k, int &j) {
+	std::unique_ptr<ParseNode<Token>> makeParseTree(const ProductionVector &productions, const std::vector<Token> &word,
+													int &k, int &j) {
 		std::vector<std::unique_ptr<ParseNode<Token>>> children;
-		auto										  &product = std::get<1>(productions[k].get().second);
+		auto										  &product = productions[k].get().production;
 		int											   old_k   = k;
 		++k;
 
@@ -66,7 +65,7 @@ class RegexParser : public fl::Parser<fl::Token> {
 				if (!child->children.empty()) children.push_back(std::move(child));
 			}
 		}
-		auto t = std::get<2>(productions[old_k].get().first);
+		auto t = productions[old_k].get().lhs;
 		if (children.size() == 1 && !skipped_star && t != Tuple) { return std::move(children[0]); }
 		if (is_excl) t.data = reinterpret_cast<uint8_t *>('!');
 		return std::make_unique<ParseNode<Token>>(t, std::move(children));
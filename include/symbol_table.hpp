@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <ranges>
+#include <vector>
+
+#include "concepts.hpp"
+#include "datastructures.hpp"
+
+namespace fl {
+
+template <isLetter Letter>
+class CFG;
+
+/**
+ * @brief Numbers the symbols of a grammar or an automaton 0, 1, 2, ... so that engines can index arrays, table rows
+ * and bitsets with them instead of hashing letters. The terminals of a grammar come first, so a symbol is a terminal
+ * exactly when it is smaller than terminalCount().
+ *
+ * @tparam Letter - type of the symbols in the alphabet
+ */
+template <class Letter>
+class SymbolTable {
+   public:
+	using Symbol				 = std::uint32_t;
+	static constexpr Symbol none = -1;
+
+   private:
+	std::vector<Letter>				  letters;
+	fl::unordered_map<Letter, Symbol> index;
+	Symbol							  terminals = 0;
+
+   public:
+	SymbolTable() = default;
+
+	/// numbers the letters of an alphabet in the order they come in
+	template <std::ranges::input_range Alphabet>
+	explicit SymbolTable(const Alphabet &alphabet) {
+		for (const Letter l : alphabet) {
+			add(l);
+		}
+		terminals = size();
+	}
+
+	/// numbers the terminals, then the non-terminals of a grammar
+	explicit SymbolTable(const CFG<Letter> &g) {
+		index.reserve(g.terminals.size() + g.nonTerminals.size());
+		for (const auto l : g.terminals) {
+			add(l);
+		}
+		terminals = size();
+		for (const auto l : g.nonTerminals) {
+			add(l);
+		}
+	}
+
+	/// the symbol of a letter, a new one if it has none yet
+	Symbol add(const Letter l) {
+		auto [it, inserted] = index.try_emplace(l, Symbol(letters.size()));
+		if (inserted) letters.push_back(l);
+		return it->second;
+	}
+
+	/// the symbol of a letter, or none
+	Symbol find(const Letter l) const {
+		auto it = index.find(l);
+		return it == index.end() ? none : it->second;
+	}
+
+	Symbol operator[](const Letter l) const { return find(l); }
+	Letter letter(Symbol s) const { return letters[s]; }
+	bool   contains(const Letter l) const { return index.contains(l); }
+
+	std::size_t size() const { return letters.size(); }
+	std::size_t terminalCount() const { return terminals; }
+	std::size_t nonTerminalCount() const { return letters.size() - terminals; }
+	bool		isTerminal(Symbol s) const { return s < terminals; }
+
+	/// the symbols of the letters of a word, none for the letters that have no symbol
+	std::vector<Symbol> encode(const std::vector<Letter> &word) const {
+		std::vector<Symbol> result;
+		result.reserve(word.size());
+		for (const Letter l : word) {
+			result.push_back(find(l));
+		}
+		return result;
+	}
+
+	/// the letters of a word of symbols
+	std::vector<Letter> decode(const std::vector<Symbol> &word) const {
+		std::vector<Letter> result;
+		result.reserve(word.size());
+		for (const Symbol s : word) {
+			result.push_back(letters[s]);
+		}
+		return result;
+	}
+
+	auto begin() const { return letters.begin(); }
+	auto end() const { return letters.end(); }
+};
+
+}	  // namespace fl
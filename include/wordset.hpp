@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <iterator>
+#include <memory_resource>
 #include <ostream>
 #include <span>
 #include <stdexcept>
@@ -9,41 +10,75 @@
 #include <vector>
 #include <ranges>
 
+#include "hashing.hpp"
+
 namespace fl {
 
 template <class Letter>
 class WordSet {
    public:
-	using WordID = unsigned int;
+	using WordID		 = unsigned int;
+	using allocator_type = std::pmr::polymorphic_allocator<>;
 	struct WordData {
 		size_t start;
 		size_t length;
 	};
 
    private:
-	std::vector<Letter>	  words;
-	std::vector<WordData> wordsData;
+	std::pmr::vector<Letter>   words;
+	std::pmr::vector<WordData> wordsData;
+	std::pmr::vector<bool>	   released;	 // [id] -> whether release() was called for the word
 
-	WordID nextWordID = 0;
+	WordID nextWordID  = 0;
+	size_t deadLetters = 0;	   // letters of the pool that no word refers to anymore
+
+	void countDeadLetters() {
+		size_t liveLength = 0;
+		for (const auto &data : wordsData) {
+			liveLength += data.length;
+		}
+		deadLetters = words.size() > liveLength ? words.size() - liveLength : 0;
+	}
 
    public:
-	WordSet() { addWord(std::span<Letter>{}); }
+	WordSet() : WordSet(allocator_type()) {}
+	explicit WordSet(const allocator_type &alloc) : words(alloc), wordsData(alloc), released(alloc) {
+		addWord(std::span<Letter>{});
+	}
+
+	WordSet(std::pmr::vector<Letter> &&words_, std::pmr::vector<WordData> &&wordsData_)
+		: words(std::move(words_)), wordsData(std::move(wordsData_)),
+		  released(wordsData.size(), false, wordsData.get_allocator()), nextWordID(wordsData.size()) {
+		countDeadLetters();
+	}
+	WordSet(const std::pmr::vector<Letter> &words_, const std::pmr::vector<WordData> &wordsData_,
+			const allocator_type &alloc = allocator_type())
+		: words(words_, alloc), wordsData(wordsData_, alloc), released(wordsData_.size(), false, alloc),
+		  nextWordID(wordsData.size()) {
+		countDeadLetters();
+	}
 
-	WordSet(std::vector<Letter> &&words_, std::vector<WordData> &&wordsData_)
-		: words(std::move(words_)), wordsData(std::move(wordsData_)), nextWordID(wordsData.size()) {}
-	WordSet(const std::vector<Letter> &words_, const std::vector<WordData> &wordsData_)
-		: words(std::move(words_)), wordsData(std::move(wordsData_)), nextWordID(wordsData.size()) {}
+	allocator_type get_allocator() const { return words.get_allocator(); }
 
 	template <class Input>
 	WordID addWord(Input &&word) {
 		wordsData.emplace_back(words.size(), word.size());
 		words.insert(words.end(), word.begin(), word.end());
+		released.push_back(false);
 		return nextWordID++;
 	}
 
+	/// the copy gets its own letters, so that every letter of the pool belongs to one word and the dead letters can
+	/// be counted when words are shortened or released
 	WordID copyWord(WordID id) {
 		if (id >= nextWordID) { throw std::out_of_range("Invalid WordID"); }
-		wordsData.emplace_back(wordsData[id].start, wordsData[id].length);
+		const auto [start, length] = wordsData[id];
+		wordsData.emplace_back(words.size(), length);
+		words.reserve(words.size() + length);
+		for (size_t i = start; i < start + length; ++i) {
+			words.push_back(words[i]);
+		}
+		released.push_back(false);
 		return nextWordID++;
 	}
 
@@ -63,18 +98,49 @@ class WordSet {
 	size_t totalLength() const { return words.size(); }
 	size_t size() const { return nextWordID; }
 
+	/// letters in the pool that no word refers to anymore
+	size_t deadLength() const { return deadLetters; }
+
+	/// whether compact() can give memory back, which a monotonic_buffer_resource only does when it is destroyed
+	bool canReclaim() const {
+		auto *resource = get_allocator().resource();
+		return dynamic_cast<std::pmr::monotonic_buffer_resource *>(resource) == nullptr;
+	}
+
 	void replaceWithSubstr(WordID id, size_t offset, size_t length) {
 		if (id >= nextWordID) { throw std::out_of_range("Invalid WordID"); }
 		if (offset + length > wordsData[id].length) { throw std::out_of_range("Substring exceeds word length"); }
 		auto &[start, wordLength] = wordsData[id];
+		deadLetters += wordLength - length;
 		start += offset;
 		wordLength = length;
 	}
 
+	/// marks a word that nothing refers to anymore. Its letters are dead and compact() drops its ID
+	void release(WordID id) {
+		if (id >= nextWordID) { throw std::out_of_range("Invalid WordID"); }
+		if (released[id]) return;
+		released[id] = true;
+		deadLetters += wordsData[id].length;
+		wordsData[id].length = 0;
+	}
+
+	/**
+	 * @brief Rewrites the pool so it holds only the letters of the words that are not released, each distinct word
+	 * stored once.
+	 *
+	 * @return remap - the new ID of every old word ID, equal words get the same ID and released ones get noWord
+	 */
+	std::vector<WordID> compact();
+
+	static constexpr WordID noWord = -1;
+
 	void clear() {
 		words.clear();
 		wordsData.clear();
-		nextWordID = 0;
+		released.clear();
+		nextWordID	= 0;
+		deadLetters = 0;
 	}
 
 	class Iterator {
@@ -101,21 +167,22 @@ class WordSet {
 
 template <class Letter>
 class UniqueWordSet {
-	std::vector<Letter> words;
+	std::pmr::vector<Letter> words;
 
    public:
-	using WordID = unsigned int;
+	using WordID		 = unsigned int;
+	using allocator_type = std::pmr::polymorphic_allocator<>;
 	class mySpan {
 	   public:
-		size_t				 start;
-		size_t				 size;
-		std::vector<Letter> &words;
+		size_t					  start;
+		size_t					  size;
+		std::pmr::vector<Letter> &words;
 
 		auto begin() const { return words.data() + start; }
 		auto end() const { return words.data() + start + size; }
 
-		mySpan(const std::vector<Letter> &words, size_t start, size_t size)
-			: start(start), size(size), words(const_cast<std::vector<Letter> &>(words)) {}
+		mySpan(const std::pmr::vector<Letter> &words, size_t start, size_t size)
+			: start(start), size(size), words(const_cast<std::pmr::vector<Letter> &>(words)) {}
 
 		bool operator==(const mySpan &other) const {
 			return this->size == other.size && std::equal(this->begin(), this->end(), other.begin());
@@ -130,22 +197,13 @@ class UniqueWordSet {
    private:
 	using WordData = WordSet<Letter>::WordData;
 
-	std::vector<WordData> wordsData;
+	std::pmr::vector<WordData> wordsData;
 
 	struct myHash {
 		using is_transparent = void;	 // Allows this hash to be used in unordered_map with std::span<Letter>
-		constexpr size_t operator()(const mySpan &span) const {
-			return std::hash<std::string_view>()(
-				std::string_view(reinterpret_cast<const char *>(span.begin()), span.size));
-		}
-		constexpr size_t operator()(const std::span<Letter> &span) const {
-			return std::hash<std::string_view>()(
-				std::string_view(reinterpret_cast<const char *>(span.data()), span.size()));
-		}
-		constexpr size_t operator()(const std::span<const Letter> &span) const {
-			return std::hash<std::string_view>()(
-				std::string_view(reinterpret_cast<const char *>(span.data()), span.size()));
-		}
+		size_t operator()(const mySpan &span) const { return hashSpan(std::span<const Letter>(span.begin(), span.size)); }
+		size_t operator()(const std::span<Letter> &span) const { return hashSpan(std::span<const Letter>(span)); }
+		size_t operator()(const std::span<const Letter> &span) const { return hashSpan(span); }
 	};
 
 	struct myEqual {
@@ -157,12 +215,17 @@ class UniqueWordSet {
 		}
 	};
 
-	std::unordered_map<mySpan, WordID, myHash, myEqual> wordMap;
+	std::pmr::unordered_map<mySpan, WordID, myHash, myEqual> wordMap;
 
 	WordID nextWordID = 0;
 
    public:
-	UniqueWordSet() { addWord(std::span<Letter>{}); }
+	UniqueWordSet() : UniqueWordSet(allocator_type()) {}
+	explicit UniqueWordSet(const allocator_type &alloc) : words(alloc), wordsData(alloc), wordMap(alloc) {
+		addWord(std::span<Letter>{});
+	}
+
+	allocator_type get_allocator() const { return words.get_allocator(); }
 
 	template <class Input>
 	WordID addWord(Input &&word) {
@@ -205,12 +268,30 @@ class UniqueWordSet {
 		nextWordID = 0;
 	}
 
-	auto toWordSet() const {
-		WordSet<Letter> ws{words, wordsData};
+	auto toWordSet() const & {
+		WordSet<Letter> ws{words, wordsData, get_allocator()};
+		return ws;
+	}
+
+	auto toWordSet() && {
+		WordSet<Letter> ws{std::move(words), std::move(wordsData)};
 		return ws;
 	}
 };
 
+template <class Letter>
+std::vector<typename WordSet<Letter>::WordID> WordSet<Letter>::compact() {
+	UniqueWordSet<Letter> unique(get_allocator());
+	std::vector<WordID>	  remap(nextWordID, noWord);
+	for (WordID id = 0; id < nextWordID; ++id) {
+		if (!released[id]) remap[id] = unique.addWord(getWord(id));
+	}
+	*this = std::move(unique).toWordSet();
+	words.shrink_to_fit();
+	wordsData.shrink_to_fit();
+	return remap;
+}
+
 template <class Letter>
 class ExtendableWordSet {
 	std::vector<std::vector<Letter>> data;
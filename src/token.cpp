@@ -24,7 +24,12 @@ Token Token::createToken(const std::string &name, std::size_t value) {
 }
 
 Token Token::createDependentToken(const Token &base) {
-	getTokenNames().insert({++Token::size, getTokenNames().find(base.value)->second + "'"});
+	// a character token, like the terminals of a grammar, has no name of its own
+	auto		it	 = getTokenNames().find(base.value);
+	std::string name = it != getTokenNames().end() ? it->second
+				   : base.value < 128			   ? std::string(1, static_cast<char>(base.value))
+												   : std::to_string(base.value);
+	getTokenNames().insert({++Token::size, name + "'"});
 	return Token(Token::size);
 }
 
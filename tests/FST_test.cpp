@@ -1,4 +1,6 @@
+#include <cassert>
 #include <iostream>
+#include <thread>
 
 #include <FST.hpp>
 #include <TFSA.hpp>
@@ -71,6 +73,8 @@ void test_bounded_variation() {
 		std::cout << "FSA is functional." << std::endl;
 	}
 
+	std::cout << "twins property: " << testTwinsProperty(fsa) << std::endl;
+
 	try {
 		SSFT<Letter> ssft(std::move(fsa));
 		std::cout << "SSFT has " << ssft.N << " states and " << ssft.transitions.size() << " transitions and "
@@ -84,6 +88,54 @@ void test_bounded_variation() {
 	}
 }
 
+void test_bounded_variation_threads() {
+	// determinizable, so its delays stay bounded
+	TFSA<Letter> bounded;
+	bounded.N		= 8;
+	bounded.qFirsts = {0, 1};
+	bounded.qFinals = {3, 6, 7};
+	bounded.addTransition(0, 'a', toLetter("c"), 2);
+	bounded.addTransition(0, 'a', toLetter("cc"), 3);
+	bounded.addTransition(1, 'a', toLetter("cc"), 3);
+	bounded.addTransition(1, 'a', toLetter("ccc"), 4);
+	bounded.addTransition(2, 'b', toLetter("ccd"), 5);
+	bounded.addTransition(3, 'b', toLetter("cd"), 5);
+	bounded.addTransition(4, 'b', toLetter("dd"), 6);
+	bounded.addTransition(5, 'a', toLetter("d"), 7);
+	bounded.addTransition(6, 'a', toLetter(""), 7);
+
+	// on a^n one path has written a^n and the other nothing
+	TFSA<Letter> unbounded;
+	unbounded.N		  = 4;
+	unbounded.qFirsts = {0};
+	unbounded.qFinals = {0, 1, 3};
+	unbounded.addTransition(0, 'a', toLetter("a"), 1);
+	unbounded.addTransition(1, 'a', toLetter("a"), 1);
+	unbounded.addTransition(0, 'a', toLetter(""), 2);
+	unbounded.addTransition(2, 'a', toLetter(""), 2);
+	unbounded.addTransition(2, 'b', toLetter("b"), 3);
+
+	// every output is empty, so C * |Q|^2 is 0 and so are all the delays
+	TFSA<Letter> silent;
+	silent.N	   = 3;
+	silent.qFirsts = {0};
+	silent.qFinals = {1, 2};
+	silent.addTransition(0, 'a', toLetter(""), 1);
+	silent.addTransition(0, 'a', toLetter(""), 2);
+	silent.addTransition(1, 'a', toLetter(""), 1);
+	silent.addTransition(2, 'a', toLetter(""), 2);
+
+	const unsigned int threads = std::max(2u, std::thread::hardware_concurrency());
+	for (const auto &[fsa, expected] :
+		 {std::pair{&bounded, true}, std::pair{&unbounded, false}, std::pair{&silent, true}}) {
+		BoundedVariationStats single, sharded;
+		assert(testBoundedVariation(*fsa, single) == expected);
+		assert(testBoundedVariation(*fsa, sharded, threads) == expected);
+		if (expected) assert(single.maxDelay == sharded.maxDelay);
+		std::cout << "bounded variation with 1 and " << threads << " threads: " << expected << std::endl;
+	}
+}
+
 void test_replace() {
 	auto r = rgx::optionalReplace("<':)','😄'>+<'=D', '🍄'>", "abcd");
 	auto t = rgx::parseRegex(r);
@@ -102,6 +154,14 @@ void test_replace() {
 	// fsa.print(std::cout);
 	//drawFSA(fst);
 
+	BENCH(realtimeFST(FST<Letter>(fst)), 100, "BENCH realtimeFST: ");
+	BENCH(
+		{
+			std::pmr::monotonic_buffer_resource arena;
+			realtimeFST(FST<Letter>(fst), &arena);
+		},
+		100, "BENCH realtimeFST in an arena: ");
+
 	fst = removeEpsilonFST<Letter>(std::move(fst));
 	fst = trimFSA<Letter>(std::move(fst));
 
@@ -150,6 +210,7 @@ void test_replace() {
 int main() {
 	// test_determinization();
 	// test_bounded_variation();
+	test_bounded_variation_threads();
 	test_replace();
 
 	return 0;
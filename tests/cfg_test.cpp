@@ -1,6 +1,7 @@
 #include "cfg.h"
 #include <assert.h>
 #include "letter.hpp"
+#include "symbol_table.hpp"
 
 int main() {
 	fl::CFG<fl::Letter> g;
@@ -19,6 +20,43 @@ int main() {
 
 	g.printParseTable();
 
+	fl::SymbolTable<fl::Letter> symbols(g);
+	assert(symbols.size() == 11 && symbols.terminalCount() == 6 && symbols.nonTerminalCount() == 5);
+	for (const auto l : g.terminals) {
+		assert(symbols.isTerminal(symbols[l]) && symbols.letter(symbols[l]) == l);
+	}
+	for (const auto l : g.nonTerminals) {
+		assert(!symbols.isTerminal(symbols[l]) && symbols.letter(symbols[l]) == l);
+	}
+	assert(symbols['x'] == symbols.none);
+	std::vector<fl::Letter> word = {'(', 'i', '+', 'i', ')', '#'};
+	assert(symbols.decode(symbols.encode(word)) == word);
+
+	using Set			= fl::unordered_set<fl::Letter>;
+	const auto nullable = g.findNullables();
+	const auto first	= g.findFirsts(nullable);
+	const auto follow	= g.findFollows(nullable, first);
+	assert(nullable.at('E') && nullable.at('T') && !nullable.at('e') && !nullable.at('f') && !nullable.at('i'));
+	assert(first.at('e') == Set({'(', 'i'}) && first.at('E') == Set({'+'}) && first.at('T') == Set({'.'}));
+	assert(first.at('+') == Set({'+'}));
+	assert(follow.at('e') == Set({')', '#'}) && follow.at('E') == Set({')', '#'}));
+	assert(follow.at('t') == Set({'+', ')', '#'}) && follow.at('f') == Set({'.', '+', ')', '#'}));
+
+	// A is nullable through its second rule, whichever of its rules is looked at first
+	fl::CFG<fl::Letter> h;
+	h.terminals	   = {'c', '#'};
+	h.nonTerminals = {'S', 'A', 'B'};
+	h.addRule('S', "Ac");
+	h.addRule('A', "Bc");
+	h.addRule('A', "B");
+	h.addRule('B', "");
+	h.start = 'S';
+	h.eof	= '#';
+	const auto hNullable = h.findNullables();
+	assert(hNullable.at('A') && hNullable.at('B') && !hNullable.at('S'));
+	assert(h.findFirsts(hNullable).at('S') == Set({'c'}));
+	assert(h.findFollows(hNullable, h.findFirsts(hNullable)).at('B') == Set({'c'}));
+
 	srand(time(0));
 	// std::cout << g.generate(90, 110) << std::endl;
 }
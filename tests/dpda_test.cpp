@@ -1,9 +1,21 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <cstring>
+#include <filesystem>
+#include <memory_resource>
+#include <ranges>
+#include <regex>
 #include <unordered_set>
 #include <utils.h>
 #include <parser.h>
+#include <incremental_parser.hpp>
+#include <grammar_transforms.hpp>
+#include <lr_parser.hpp>
+#include <earley.hpp>
+#include <cyk.hpp>
 #include <letter.hpp>
+#include <token.h>
 
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "../doctest.h"
@@ -191,6 +203,618 @@ TEST_CASE("arithmetics from grammar") {
 	out.close();
 }
 
+/// the grammar of "arithmetics from grammar". With ast, the + and the parentheses are left out of the AST, and the
+/// nodes of a sum and of a parenthesized expression are named S and P
+static CFG<Letter> arithmeticGrammar(bool ast = false) {
+	CFG<Letter> g;
+	g.terminals	   = {'i', '(', ')', '.', '+', '#'};
+	g.nonTerminals = {'e', 'E', 't', 'T', 'f'};
+	g.addRule('e', "tE");
+	g.addRule('E', "");
+	if (ast) g.addRule('E', Production<Letter>({'+', 't', 'E'}, {true, false, false}, 'S'));
+	else g.addRule('E', "+tE");
+	g.addRule('t', "fT");
+	g.addRule('T', "");
+	g.addRule('T', ".fT");
+	if (ast) g.addRule('f', Production<Letter>({'(', 'e', ')'}, {true, false, true}, 'P'));
+	else g.addRule('f', "(e)");
+	g.addRule('f', "i");
+	g.start = 'e';
+	g.eof	= '#';
+	return g;
+}
+
+TEST_CASE("flat parse tree") {
+	CFG<Letter> g = arithmeticGrammar();
+
+	Parser<Letter> a(g);
+
+	for (const char *str : {"(i+i).i#", "(i+i).i.(i.(i+i+i+i)).(i+i+i)#", "i#"}) {
+		auto tree = a.parse(str);
+
+		std::vector<Letter>					w(str, str + strlen(str));
+		std::pmr::monotonic_buffer_resource arena;
+		auto								flat = a.parseFlat(w, &arena);
+
+		std::stringstream expected, fromFlat, printed;
+		expected << tree;
+		fromFlat << flat.toParseNode();
+		printed << flat;
+		CHECK(expected.str() == fromFlat.str());
+		CHECK(expected.str() == printed.str());
+		CHECK(flat.root() + 1 == flat.size());
+
+		// the visitor reaches every node once, and leaves it at the depth it entered it
+		std::size_t				 entered = 0, leaves = 0;
+		std::vector<std::size_t> depths;
+		flat.visit(
+			[&](auto, std::size_t depth) {
+				++entered;
+				depths.push_back(depth);
+			},
+			[&](auto id, std::size_t depth) {
+				CHECK(depths.back() == depth);
+				depths.pop_back();
+				if (flat.children(id).empty()) ++leaves;
+			});
+		CHECK(entered == flat.size());
+		CHECK(leaves == std::ranges::count_if(flat, [](const auto &n) { return n.childCount == 0; }));
+	}
+
+	CHECK_THROWS_PRINT(a.parseFlat(std::vector<Letter>{'(', 'i', '#'}));
+}
+
+TEST_CASE("LL(1) table agrees with the automaton") {
+	CFG<Letter> g = arithmeticGrammar();
+
+	Parser<Letter>					   a(g);
+	const DPDA<State<Letter>, Letter> &automaton = a;
+
+	std::string alphabet = "i().+#x";
+	srand(37);
+	for (int n = 0; n < 2000; ++n) {
+		std::vector<Letter> w;
+		for (int k = rand() % 12; k > 0; --k) {
+			w.push_back(alphabet[rand() % (alphabet.size() - (n % 2))]);
+		}
+		if (n % 3) w.push_back('#');
+		CHECK(a.recognize(w) == automaton.recognize(w));
+	}
+	CHECK(a.recognize("((i+i).i)#"));
+	CHECK_FALSE(a.recognize("((i+i).i)"));
+	CHECK_FALSE(a.recognize("((i+i).i)##"));
+
+	// on a conflict the table and the automaton keep the same rule, so they accept the same words and every way to
+	// parse gives the same derivation
+	CFG<Letter> c;
+	c.terminals	   = {'a', 'b', 'c', '#'};
+	c.nonTerminals = {'S', 'A'};
+	c.addRule('S', "Ab");
+	c.addRule('S', "ac");
+	c.addRule('A', "a");
+	c.start = 'S';
+	c.eof	= '#';
+
+	Parser<Letter>					   conflict(c);
+	const DPDA<State<Letter>, Letter> &conflictAutomaton = conflict;
+	for (const std::vector<Letter> w : {std::vector<Letter>{'a', 'b', '#'}, std::vector<Letter>{'a', 'c', '#'}}) {
+		CHECK(conflict.recognize(w) == conflictAutomaton.recognize(w));
+		if (!conflict.recognize(w)) continue;
+
+		auto [accepted, productions] = conflict.generateProductions(w);
+		CHECK(accepted);
+		CHECK(productions.size() == (w[1] == 'b' ? 2 : 1));
+
+		std::stringstream tree, flat;
+		tree << conflict.parse(w);
+		flat << conflict.parseFlat(w).toParseNode();
+		CHECK(tree.str() == flat.str());
+	}
+}
+
+TEST_CASE("parse events") {
+	CFG<Letter> g = arithmeticGrammar(true);
+
+	g.getNonTerminalData('E').upwardSpillThreshold = 2;
+	g.getNonTerminalData('T').ignoreSingleChild	   = false;
+	g.getNonTerminalData('t').ignoreEmpty		   = false;
+
+	Parser<Letter> a(g);
+
+	struct Counter : ParseEventHandler<Letter> {
+		std::size_t terminals = 0, depth = 0, maxDepth = 0;
+		void		enter(const Letter) { maxDepth = std::max(maxDepth, ++depth); }
+		void		terminal(const Letter l) { terminals += l != Letter::eps; }
+		void		exit(const Letter) { --depth; }
+	};
+
+	for (const char *str : {"(i+i).i#", "(i+i).i.(i.(i+i+i+i)).(i+i+i)#", "i#", "((i))#"}) {
+		std::vector<Letter> w(str, str + strlen(str));
+
+		std::stringstream		 expected, actual;
+		ParseTreeBuilder<Letter> builder;
+		CHECK(a.parseEvents(w, builder));
+		expected << a.parseFlat(w);
+		actual << builder.take();
+		CHECK(expected.str() == actual.str());
+
+		std::stringstream		 expectedAST, actualAST;
+		ParseTreeBuilder<Letter> ASTbuilder;
+		CHECK(a.ASTparseEvents(w, ASTbuilder));
+		expectedAST << a.ASTparse(w);
+		actualAST << ASTbuilder.take().toParseNode();
+		CHECK(expectedAST.str() == actualAST.str());
+
+		Counter counter;
+		a.parseEvents(w, counter);
+		CHECK(counter.terminals + 1 == w.size());
+		CHECK(counter.depth == 0);
+	}
+
+	CHECK_THROWS_PRINT(a.parseEvents(std::vector<Letter>{'(', 'i', '#'}, ParseEventHandler<Letter>{}));
+}
+
+TEST_CASE("parse a stream of tokens") {
+	CFG<Letter> g = arithmeticGrammar(true);
+
+	Parser<Letter> a(g);
+	auto		   toLetter = [](char c) { return Letter(c); };
+
+	for (const char *str : {"(i+i).i", "(i + i) . i . (i.(i+i+i+i)).(i+i+i)", "i", "((i))", "i#"}) {
+		std::string		  word(str);
+		std::vector<Letter> w;
+		std::ranges::copy(word | std::views::filter([](char c) { return c != ' '; }), std::back_inserter(w));
+		if (w.back() != '#') w.push_back('#');
+
+		std::istringstream in(word);
+		CHECK(a.recognize(std::views::istream<char>(in), toLetter));
+
+		std::stringstream		 expected, actual;
+		ParseTreeBuilder<Letter> builder;
+		in = std::istringstream(word);
+		CHECK(a.parseEvents(std::views::istream<char>(in), builder, toLetter));
+		expected << a.parseFlat(w);
+		actual << builder.take();
+		CHECK(expected.str() == actual.str());
+
+		std::stringstream		 expectedAST, actualAST;
+		ParseTreeBuilder<Letter> ASTbuilder;
+		in = std::istringstream(word);
+		CHECK(a.ASTparseEvents(std::views::istream<char>(in), ASTbuilder, toLetter));
+		expectedAST << a.ASTparse(w);
+		actualAST << ASTbuilder.take().toParseNode();
+		CHECK(expectedAST.str() == actualAST.str());
+	}
+
+	auto parseStream = [&](const char *str) {
+		std::istringstream in(str);
+		return a.parseEvents(std::views::istream<char>(in), ParseEventHandler<Letter>{}, toLetter);
+	};
+	for (const char *str : {"(i+i", "(i+)", "i)", "i#i", "i##", "ix", ""}) {
+		std::istringstream in(str);
+		CHECK_FALSE(a.recognize(std::views::istream<char>(in), toLetter));
+		CHECK_THROWS_AS(parseStream(str), ParseError);
+		try {
+			parseStream(str);
+		} catch (const ParseError &e) { std::cerr << e << std::endl; }
+	}
+}
+
+TEST_CASE("saved parse table") {
+	CFG<Letter> g		   = arithmeticGrammar(true);
+	g.nonTerminalData['t'] = {.upwardSpillThreshold = 1, .ignoreEmpty = true, .ignoreSingleChild = false};
+
+	Parser<Letter> built(g);
+	const auto	   blob = built.save();
+	Parser<Letter> loaded(g, blob);
+	CHECK(loaded.save() == blob);
+
+	for (const char *str : {"(i+i).i#", "i.(i.(i+i+i+i)).(i+i+i)#", "i#", "((i))#"}) {
+		std::stringstream expected, actual, expectedAST, actualAST;
+		CHECK(loaded.recognize(str));
+		expected << built.parseFlat(toLetter<Letter>(str));
+		actual << loaded.parseFlat(toLetter<Letter>(str));
+		CHECK(expected.str() == actual.str());
+		expectedAST << built.ASTparse(str);
+		actualAST << loaded.ASTparse(str);
+		CHECK(expectedAST.str() == actualAST.str());
+	}
+	for (const char *str : {"(i+i#", "i)#", "ix#"}) {
+		CHECK_FALSE(loaded.recognize(str));
+		CHECK_THROWS_AS(loaded.parse(str), ParseError);
+	}
+
+	// a table saved for another grammar, or a damaged one, is not loaded
+	CFG<Letter> changed = g;
+	changed.addRule('f', "+");
+	CHECK_THROWS_AS(Parser<Letter>(changed, blob), std::runtime_error);
+	CHECK_THROWS_AS(Parser<Letter>(g, std::span(blob).first(blob.size() - 1)), std::runtime_error);
+	auto damaged = blob;
+	damaged[16]	 = std::byte(0xff);	 // the number of symbols
+	CHECK_THROWS_AS(Parser<Letter>(g, damaged), std::runtime_error);
+
+	// a cache file is written on the first run and loaded on the next
+	const auto cache = std::filesystem::temp_directory_path() / "dpda_test_parser.fll1";
+	std::filesystem::remove(cache);
+	Parser<Letter> first(g, cache);
+	CHECK(readBlob(cache) == blob);
+	Parser<Letter> second(g, cache);
+	CHECK(second.recognize("(i+i).i#"));
+	std::filesystem::remove(cache);
+}
+
+TEST_CASE("left recursion and left factoring") {
+	CFG<Letter> g;
+	g.terminals	   = {'i', '(', ')', '[', ']', '+', '.', '#'};
+	g.nonTerminals = {'E', 'T', 'F'};
+	g.addRule('E', Production<Letter>({'E', '+', 'T'}, {false, true, false}, 'S'));
+	g.addRule('E', "T");
+	g.addRule('T', Production<Letter>({'T', '.', 'F'}, {false, true, false}, 'M'));
+	g.addRule('T', "F");
+	g.addRule('F', Production<Letter>({'(', 'E', ')'}, {true, false, true}, 'P'));
+	g.addRule('F', "i");
+	g.addRule('F', Production<Letter>({'i', '[', 'E', ']'}, {false, true, false, true}));
+	g.start = 'E';
+	g.eof	= '#';
+
+	auto		   fresh = [](const Letter base) { return Letter(base == 'E' ? 'x' : base == 'T' ? 'y' : 'z'); };
+	Parser<Letter> transformed(toLL1Form(g, fresh));
+
+	// what the same grammar looks like written for LL(1) by hand
+	CFG<Letter> h;
+	h.terminals = g.terminals;
+	h.addRule('E', "Tx");
+	h.addRule('x', Production<Letter>({'+', 'T', 'x'}, {true, false, false}, 'S'));
+	h.addRule('x', "");
+	h.addRule('T', "Fy");
+	h.addRule('y', Production<Letter>({'.', 'F', 'y'}, {true, false, false}, 'M'));
+	h.addRule('y', "");
+	h.addRule('F', Production<Letter>({'(', 'E', ')'}, {true, false, true}, 'P'));
+	h.addRule('F', "iz");
+	h.addRule('z', Production<Letter>({'[', 'E', ']'}, {true, false, true}));
+	h.addRule('z', "");
+	h.getNonTerminalData('z') = {.upwardSpillThreshold = INT_MAX, .ignoreEmpty = true, .ignoreSingleChild = false};
+	h.start					  = 'E';
+	h.eof					  = '#';
+	Parser<Letter> byHand(h);
+
+	for (const char *str : {"i#", "i+i#", "i+i.i+i#", "(i+i).i[i+i]#", "i[i[i]].(i)#"}) {
+		std::stringstream expected, actual;
+		expected << byHand.ASTparse(str);
+		actual << transformed.ASTparse(str);
+		CHECK(expected.str() == actual.str());
+	}
+
+	// every word up to length 4 is in both languages or in neither
+	auto words = [](const CFG<Letter> &grammar) {
+		std::vector<std::vector<Letter>> result = {{}};
+		for (std::size_t i = 0; i < result.size() && result[i].size() < 4; ++i) {
+			for (const auto l : grammar.terminals) {
+				if (l == grammar.eof) continue;
+				result.push_back(result[i]);
+				result.back().push_back(l);
+			}
+		}
+		for (auto &word : result) {
+			word.push_back(grammar.eof);
+		}
+		return result;
+	};
+	for (const auto &word : words(g)) {
+		CHECK(transformed.recognize(word) == byHand.recognize(word));
+	}
+
+	// left recursion through another non-terminal: A => Bab => Aba
+	CFG<Letter> indirect;
+	indirect.terminals = {'a', 'b', 'c', 'd', '#'};
+	indirect.addRule('A', "Ba");
+	indirect.addRule('A', "c");
+	indirect.addRule('B', "Ab");
+	indirect.addRule('B', "d");
+	indirect.addRule('B', "dd");
+	indirect.start = 'A';
+	indirect.eof   = '#';
+
+	auto		   freshDigit = [next = '0'](const Letter) mutable { return Letter(next++); };
+	Parser<Letter> rewritten(toLL1Form(indirect, freshDigit));
+	for (const auto &word : words(indirect)) {
+		std::string text(word.begin(), word.end() - 1);
+		CHECK(rewritten.recognize(word) == std::regex_match(text, std::regex("(c|da|dda)(ba)*")));
+	}
+}
+
+TEST_CASE("Chomsky normal form and CYK") {
+	// E -> E+T | T, T -> T.F | F, F -> (E) | i
+	CFG<Letter> arithmetic;
+	arithmetic.terminals = {'i', '(', ')', '.', '+', '#'};
+	arithmetic.addRule('E', "E+T");
+	arithmetic.addRule('E', "T");
+	arithmetic.addRule('T', "T.F");
+	arithmetic.addRule('T', "F");
+	arithmetic.addRule('F', "(E)");
+	arithmetic.addRule('F', "i");
+	arithmetic.start = 'E';
+
+	// ambiguous, with infinitely many ways to derive eps
+	CFG<Letter> ambiguous;
+	ambiguous.terminals = {'i', '+', '#'};
+	ambiguous.addRule('E', "E+E");
+	ambiguous.addRule('E', "EE");
+	ambiguous.addRule('E', "N");
+	ambiguous.addRule('E', "i");
+	ambiguous.addRule('N', "");
+	ambiguous.start = 'E';
+
+	// the start symbol is nullable and on a right side
+	CFG<Letter> balanced;
+	balanced.terminals = {'a', 'b', '#'};
+	balanced.addRule('S', "aSbS");
+	balanced.addRule('S', "");
+	balanced.start = 'S';
+
+	// a cycle of unit rules, a non-terminal that derives no word and one that is never reached
+	CFG<Letter> units;
+	units.terminals = {'a', 'b', 'c', 'd', '#'};
+	units.addRule('S', "A");
+	units.addRule('S', "Bc");
+	units.addRule('A', "B");
+	units.addRule('A', "a");
+	units.addRule('B', "A");
+	units.addRule('B', "bB");
+	units.addRule('B', "C");
+	units.addRule('C', "Cc");
+	units.addRule('D', "d");
+	units.start = 'S';
+
+	for (const auto *g : {&arithmetic, &ambiguous, &balanced, &units}) {
+		auto fresh = [next = '\x80'](const Letter) mutable { return Letter(next++); };
+		const auto useful  = removeUseless(*g);
+		const auto noEps   = removeEpsilonRules(*g, fresh);
+		const auto noUnits = removeUnitRules(*g);
+		const auto cnf	   = toChomskyNormalForm(*g, fresh);
+
+		CHECK_FALSE(useful.nonTerminals.contains('C'));
+		CHECK_FALSE(useful.nonTerminals.contains('D'));
+		for (const auto &[A, v] : noEps.rules) {
+			CHECK((!v.empty() || A == noEps.start));
+		}
+		for (const auto &[A, v] : noUnits.rules) {
+			CHECK_FALSE((v.size() == 1 && noUnits.nonTerminals.contains(v[0])));
+		}
+		for (const auto &[A, v] : cnf.rules) {
+			if (v.empty()) CHECK(A == cnf.start);
+			else if (v.size() == 1) CHECK_FALSE(cnf.nonTerminals.contains(v[0]));
+			else {
+				CHECK(v.size() == 2);
+				for (const auto X : v) {
+					CHECK(cnf.nonTerminals.contains(X));
+					CHECK(X != cnf.start);
+				}
+			}
+		}
+
+		EarleyParser<Letter> original(*g), withoutUseless(useful), withoutEps(noEps), withoutUnits(noUnits);
+		CYKParser<Letter>	 cyk(*g, fresh);
+
+		// every word up to length 5 is in all the languages or in none of them
+		std::vector<std::vector<Letter>> words = {{}};
+		for (std::size_t i = 0; i < words.size() && words[i].size() < 5; ++i) {
+			for (const auto l : g->terminals) {
+				if (l == '#') continue;
+				words.push_back(words[i]);
+				words.back().push_back(l);
+			}
+		}
+		std::size_t accepted = 0;
+		for (const auto &w : words) {
+			const bool expected = original.recognize(w);
+			accepted += expected;
+			CHECK(withoutUseless.recognize(w) == expected);
+			CHECK(withoutEps.recognize(w) == expected);
+			CHECK(withoutUnits.recognize(w) == expected);
+			CHECK(cyk.recognize(w) == expected);
+		}
+		CHECK(accepted > 0);
+	}
+
+	// with expect_eof the word has to end with eof
+	CYKParser<Letter> withEof(balanced, [next = '\x80'](const Letter) mutable { return Letter(next++); });
+	withEof.expect_eof = true;
+	CHECK(withEof.recognize("aabb#"));
+	CHECK(withEof.recognize("#"));
+	CHECK_FALSE(withEof.recognize(std::vector<Letter>{}));
+	CHECK_FALSE(withEof.recognize("aabb"));
+	CHECK_FALSE(withEof.recognize("aabbx"));
+
+	// the non-terminals it makes for tokens are its own, so a parser built before it still works
+	CFG<Token> tokens(Token('S'), Token::eof);
+	tokens.terminals = {'a', 'b', Token::eof};
+	tokens.addRule('S', "aSb");
+	tokens.addRule('S', "");
+
+	Parser<Token>			 ll(tokens);
+	const std::size_t		 size = Token::size;
+	CYKParser<Token>		 tokenCYK(tokens);
+	const std::vector<Token> word = {'a', 'a', 'b', 'b', Token::eof};
+	CHECK(Token::size == size);
+	tokenCYK.expect_eof = true;
+	CHECK(tokenCYK.recognize(word));
+	CHECK(ll.parse(word) != nullptr);
+	CHECK_THROWS_AS(ll.parse(std::vector<Token>{'a', 'b', 'b', Token::eof}), ParseError);
+}
+
+TEST_CASE("LALR(1) and LR(1) parsing") {
+	// the grammar from "arithmetics hardcoded", before it was rewritten for LL(1)
+	CFG<Letter> g;
+	g.terminals	   = {'i', '(', ')', '.', '+', '#'};
+	g.nonTerminals = {'e', 't', 'f'};
+	g.addRule('e', Production<Letter>({'e', '+', 't'}, {false, true, false}, 'S'));
+	g.addRule('e', "t");
+	g.addRule('t', Production<Letter>({'t', '.', 'f'}, {false, true, false}, 'M'));
+	g.addRule('t', "f");
+	g.addRule('f', Production<Letter>({'(', 'e', ')'}, {true, false, true}));
+	g.addRule('f', "i");
+	g.start = 'e';
+	g.eof	= '#';
+
+	LRParser<Letter> lalr(g);
+	LRParser<Letter> lr(g, LRParser<Letter>::Kind::LR1);
+	CHECK(lalr.stateCount() <= lr.stateCount());
+
+	// + and . are left-associative and . binds tighter. The root keeps its name, as in Parser::ASTparse
+	std::stringstream tree;
+	tree << lalr.ASTparse("i+i.i+i#");
+	CHECK(tree.str() ==
+		  "-e\n \u251c-S\n \u2502 \u251c-i\n \u2502 \u2514-M\n \u2502   \u251c-i\n \u2502   \u2514-i\n \u2514-i\n");
+
+	// on an LL(1) grammar for the same language it builds the same trees as Parser
+	CFG<Letter> ll			   = arithmeticGrammar(true);
+	ll.getNonTerminalData('T') = {.upwardSpillThreshold = 2, .ignoreEmpty = true, .ignoreSingleChild = false};
+
+	Parser<Letter>	 topDown(ll);
+	LRParser<Letter> bottomUp(ll);
+	for (const char *str : {"i#", "(i+i).i#", "(i+i).i.(i.(i+i+i+i)).(i+i+i)#", "i.i.i+(i)#"}) {
+		std::stringstream expected, actual;
+		expected << topDown.parse(str) << topDown.ASTparse(str);
+		actual << bottomUp.parse(str) << bottomUp.ASTparse(str);
+		CHECK(expected.str() == actual.str());
+	}
+
+	std::string alphabet = "i().+#";
+	srand(41);
+	for (int n = 0; n < 2000; ++n) {
+		std::vector<Letter> w;
+		for (int k = rand() % 10; k > 0; --k) {
+			w.push_back(alphabet[rand() % alphabet.size()]);
+		}
+		if (n % 4) w.push_back('#');
+		const bool expected = topDown.recognize(w);
+		CHECK(lalr.recognize(w) == expected);
+		CHECK(lr.recognize(w) == expected);
+		CHECK(bottomUp.recognize(w) == expected);
+	}
+	CHECK_THROWS_AS(lalr.parse("(i+i#"), ParseError);
+	CHECK_THROWS_AS(lalr.ASTparse("i+#"), ParseError);
+
+	// LR(1), but merging the states after "ac" and "bc" makes A and B reduce on the same lookaheads
+	CFG<Letter> merged;
+	merged.terminals = {'a', 'b', 'c', 'd', 'e', '#'};
+	merged.addRule('S', "aAd");
+	merged.addRule('S', "bBd");
+	merged.addRule('S', "aBe");
+	merged.addRule('S', "bAe");
+	merged.addRule('A', "c");
+	merged.addRule('B', "c");
+	merged.start = 'S';
+	merged.eof	 = '#';
+	CHECK_THROWS_PRINT(LRParser<Letter> lalrMerged(merged));
+	CHECK_THROWS(LRParser<Letter>(merged));
+	LRParser<Letter> canonical(merged, LRParser<Letter>::Kind::LR1);
+	for (const char *str : {"acd#", "bcd#", "ace#", "bce#"}) {
+		CHECK(canonical.recognize(str));
+	}
+	CHECK_FALSE(canonical.recognize("acc#"));
+
+	// ambiguous
+	CFG<Letter> ambiguous;
+	ambiguous.terminals = {'i', '+', '#'};
+	ambiguous.addRule('E', "E+E");
+	ambiguous.addRule('E', "i");
+	ambiguous.start = 'E';
+	ambiguous.eof	= '#';
+	CHECK_THROWS(LRParser<Letter>(ambiguous, LRParser<Letter>::Kind::LR1));
+}
+
+TEST_CASE("incremental reparsing") {
+	// a program is a list of expressions, each one ending with ;
+	CFG<Letter> g = arithmeticGrammar();
+	g.terminals.insert(';');
+	g.addRule('p', "e;p");
+	g.addRule('p', "");
+	g.start = 'p';
+
+	Parser<Letter> a(g);
+
+	std::string program;
+	for (int n = 0; n < 100; ++n) {
+		program += "i;(i+i);i.i;";
+	}
+	program += "#";
+	IncrementalParser<Letter> incremental(a, std::vector<Letter>(program.begin(), program.end()));
+
+	auto edit = [&](std::size_t offset, std::size_t count, const std::string &replacement) {
+		return incremental.edit(offset, count, std::vector<Letter>(replacement.begin(), replacement.end()));
+	};
+	auto sameTree = [&]() {
+		std::stringstream expected, actual;
+		expected << a.parseFlat(incremental.getWord());
+		actual << incremental.tree();
+		return expected.str() == actual.str();
+	};
+
+	// a statement in the middle is parsed again, not the statements after it
+	CHECK(edit(600, 0, "i+i;") <= 16);
+	CHECK(sameTree());
+	CHECK(edit(600, 1, "(i.i)") <= 16);
+	CHECK(sameTree());
+	CHECK(edit(600, 8, "") <= 16);
+	CHECK(sameTree());
+	CHECK(incremental.getWord() == std::vector<Letter>(program.begin(), program.end()));
+
+	CHECK_THROWS_AS(edit(600, 1, ")"), ParseError);
+	CHECK_THROWS_AS(edit(program.size() - 1, 1, ""), ParseError);
+	CHECK(incremental.getWord() == std::vector<Letter>(program.begin(), program.end()));
+
+	std::string alphabet = "i().+;";
+	srand(40);
+	for (int n = 0; n < 300; ++n) {
+		std::vector<Letter> word   = incremental.getWord();
+		std::size_t			offset = rand() % word.size();
+		std::size_t			count  = std::min<std::size_t>(rand() % 3, word.size() - offset);
+		std::string			replacement;
+		for (int k = rand() % 3; k > 0; --k) {
+			replacement += alphabet[rand() % alphabet.size()];
+		}
+
+		std::vector<Letter> edited = word;
+		edited.erase(edited.begin() + offset, edited.begin() + offset + count);
+		edited.insert(edited.begin() + offset, replacement.begin(), replacement.end());
+		if (a.recognize(edited)) {
+			edit(offset, count, replacement);
+			CHECK(sameTree());
+		} else {
+			CHECK_THROWS_AS(edit(offset, count, replacement), ParseError);
+			CHECK(incremental.getWord() == word);
+		}
+	}
+
+	// edits near the end of a long program, at the bottom of the spine of statements
+	std::string longProgram;
+	for (int n = 0; n < 5000; ++n) {
+		longProgram += "i;(i+i);i.i;";
+	}
+	longProgram += "#";
+	IncrementalParser<Letter> longIncremental(a, std::vector<Letter>(longProgram.begin(), longProgram.end()));
+	auto editLong = [&](std::size_t offset, std::size_t count, const std::string &replacement) {
+		return longIncremental.edit(offset, count, std::vector<Letter>(replacement.begin(), replacement.end()));
+	};
+	auto eof = [&]() { return longIncremental.getWord().size() - 1; };
+	CHECK(editLong(eof() - 12, 0, "i+i;") <= 16);
+	CHECK(editLong(eof() - 4, 1, "(i.i)") <= 16);
+	CHECK(editLong(eof() - 2, 1, "(i)") <= 16);
+	CHECK(editLong(eof(), 0, "i;") <= 16);
+	CHECK(editLong(eof() - 2, 2, "") <= 16);
+	CHECK(editLong(0, 1, "i+i") <= 16);
+
+	// the printed trees would be indented as deep as the spine
+	auto shape = [](const ParseTree<Letter> &tree) {
+		std::vector<std::pair<Letter, std::size_t>> nodes;
+		tree.visit([&](auto id, std::size_t depth) { nodes.push_back({tree.value(id), depth}); }, [](auto, auto) {});
+		return nodes;
+	};
+	CHECK(shape(a.parseFlat(longIncremental.getWord())) == shape(longIncremental.tree()));
+}
+
 TEST_CASE("ll1 finite grammar") {
 	CFG<Letter> g;
 	g.terminals	   = {'a', 'b', 'c', 'd', '#'};
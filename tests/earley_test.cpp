@@ -1,6 +1,12 @@
+#include <cstring>
+#include <regex>
+#include <set>
+#include <sstream>
 #include <earley.hpp>
 #include <cfg.h>
 #include <letter.hpp>
+#include <lr_parser.hpp>
+#include <parser.h>
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "../doctest.h"
 
@@ -46,3 +52,399 @@ TEST_CASE("grammar") {
 
 	CHECK(p.recognize({'i', '+', 'i', '.', 'i', '+', 'i', '.', '(', 'i', '+', 'i', ')'}));
 }
+
+TEST_CASE("agrees with the LL(1) and LALR(1) parsers") {
+	CFG<Letter> g;
+	g.terminals	   = {'i', '(', ')', '.', '+', '#'};
+	g.nonTerminals = {'e', 'E', 't', 'T', 'f'};
+	g.addRule('e', "tE");
+	g.addRule('E', "");
+	g.addRule('E', "+tE");
+	g.addRule('t', "fT");
+	g.addRule('T', "");
+	g.addRule('T', ".fT");
+	g.addRule('f', "(e)");
+	g.addRule('f', "i");
+	g.start = 'e';
+	g.eof	= '#';
+
+	// the same language, left-recursive
+	CFG<Letter> h;
+	h.terminals = g.terminals;
+	h.addRule('e', "e+t");
+	h.addRule('e', "t");
+	h.addRule('t', "t.f");
+	h.addRule('t', "f");
+	h.addRule('f', "(e)");
+	h.addRule('f', "i");
+	h.start = 'e';
+	h.eof	= '#';
+
+	Parser<Letter> ll(g);
+	EarleyParser<Letter> earley(g), leftRecursive(h);
+	earley.expect_eof		 = true;
+	leftRecursive.expect_eof = true;
+
+	std::string alphabet = "i().+";
+	srand(43);
+	for (int n = 0; n < 3000; ++n) {
+		std::vector<Letter> w;
+		for (int k = rand() % 12; k > 0; --k) {
+			w.push_back(alphabet[rand() % alphabet.size()]);
+		}
+		w.push_back('#');
+		const bool expected = ll.recognize(w);
+		CHECK(earley.recognize(w) == expected);
+		CHECK(leftRecursive.recognize(w) == expected);
+	}
+
+	// an item for the start symbol that is complete, but did not start at the beginning, is not enough
+	CHECK_FALSE(earley.recognize({'(', 'i', '#'}));
+	CHECK_FALSE(leftRecursive.recognize({'i', '+', '#'}));
+	CHECK_FALSE(earley.recognize({'i', 'x', '#'}));
+}
+
+TEST_CASE("ambiguous and nullable grammars") {
+	// E -> E+E | EE | N | i, N -> eps, which derives eps in infinitely many ways
+	CFG<Letter> g;
+	g.terminals = {'i', '+', '#'};
+	g.addRule('E', "E+E");
+	g.addRule('E', "EE");
+	g.addRule('E', "N");
+	g.addRule('E', "i");
+	g.addRule('N', "");
+	g.start = 'E';
+
+	EarleyParser<Letter> p(g);
+	std::string			 alphabet = "i+a";
+	srand(47);
+	for (int n = 0; n < 500; ++n) {
+		std::string w;
+		for (int k = rand() % 9; k > 0; --k) {
+			w += alphabet[rand() % (alphabet.size() - (n % 2))];
+		}
+		CHECK(p.recognize(std::vector<Letter>(w.begin(), w.end())) == std::regex_match(w, std::regex("[i+]*")));
+	}
+
+	// S -> ABC, A -> a | eps, B -> A, C -> c
+	CFG<Letter> h;
+	h.terminals = {'a', 'c', '#'};
+	h.addRule('S', "ABC");
+	h.addRule('A', "a");
+	h.addRule('A', "");
+	h.addRule('B', "A");
+	h.addRule('C', "c");
+	h.start = 'S';
+
+	EarleyParser<Letter> q(h);
+	for (const char *w : {"c", "ac", "aac"}) {
+		CHECK(q.recognize(std::vector<Letter>(w, w + strlen(w))));
+	}
+	for (const char *w : {"", "a", "aaac", "ca"}) {
+		CHECK_FALSE(q.recognize(std::vector<Letter>(w, w + strlen(w))));
+	}
+}
+
+TEST_CASE("parse forests") {
+	CFG<Letter> g;
+	g.terminals	   = {'i', '(', ')', '.', '+', '#'};
+	g.nonTerminals = {'e', 'E', 't', 'T', 'f'};
+	g.addRule('e', "tE");
+	g.addRule('E', "");
+	g.addRule('E', "+tE");
+	g.addRule('t', "fT");
+	g.addRule('T', "");
+	g.addRule('T', ".fT");
+	g.addRule('f', "(e)");
+	g.addRule('f', "i");
+	g.start = 'e';
+	g.eof	= '#';
+
+	// on an unambiguous grammar the forest holds the one tree that Parser finds
+	Parser<Letter>		 ll(g);
+	EarleyParser<Letter> earley(g);
+	earley.expect_eof = true;
+	for (const char *str : {"(i+i).i#", "(i+i).i.(i.(i+i+i+i)).(i+i+i)#", "i#"}) {
+		auto forest = earley.parseForest(std::vector<Letter>(str, str + strlen(str)));
+		CHECK_FALSE(forest.ambiguous());
+
+		auto			  trees = forest.trees();
+		std::stringstream expected, actual;
+		expected << ll.parse(str);
+		actual << trees.next();
+		CHECK(expected.str() == actual.str());
+		CHECK(trees.next() == nullptr);
+	}
+	CHECK(earley.parseForest({'i', '+', '#'}).empty());
+	CHECK(earley.parseForest({'i', '+', '#'}).extract() == nullptr);
+
+	// E -> E+E | i, where i+i+i+i has a tree for every way to put in the brackets
+	CFG<Letter> h;
+	h.terminals = {'i', '+', '#'};
+	h.addRule('E', "E+E");
+	h.addRule('E', "i");
+	h.start = 'E';
+
+	EarleyParser<Letter>	  sums(h);
+	const std::vector<Letter> w		 = {'i', '+', 'i', '+', 'i', '+', 'i'};
+	auto					  forest = sums.parseForest(w);
+	CHECK(forest.ambiguous());
+
+	std::set<std::string> distinct;
+	for (auto trees = forest.trees(); auto tree = trees.next();) {
+		std::stringstream s;
+		s << tree;
+		distinct.insert(s.str());
+	}
+	CHECK(distinct.size() == 5);
+
+	// taking the split with the longest left part everywhere makes + left-associative
+	auto leftmost = forest.extract([](const ParseForest<Letter> &f, auto, auto alternatives) {
+		std::size_t best = 0;
+		for (std::size_t k = 0; k < alternatives.size(); ++k) {
+			if (f[alternatives[k].right].start > f[alternatives[best].right].start) best = k;
+		}
+		return best;
+	});
+	for (const ParseNode<Letter> *node = leftmost.get(); node->value == 'E' && node->children.size() > 1;
+		 node							   = node->children[0].get()) {
+		CHECK(node->children[2]->children.size() == 1);
+	}
+
+	// with exponentially many trees the forest stays polynomial
+	std::vector<Letter> longer;
+	for (int k = 0; k < 30; ++k) {
+		if (k) longer.push_back('+');
+		longer.push_back('i');
+	}
+	auto big = sums.parseForest(longer);
+	CHECK(big.size() + big.packedSize() < 4 * longer.size() * longer.size() * longer.size());
+
+	// S -> SS | S | a | eps has infinitely many trees for every word, only the ones without a cycle come out
+	CFG<Letter> c;
+	c.terminals = {'a', '#'};
+	c.addRule('S', "SS");
+	c.addRule('S', "S");
+	c.addRule('S', "a");
+	c.addRule('S', "");
+	c.start = 'S';
+
+	EarleyParser<Letter> cyclic(c);
+	for (const char *str : {"", "a", "aa"}) {
+		auto		forest = cyclic.parseForest(std::vector<Letter>(str, str + strlen(str)));
+		std::size_t count  = 0;
+		for (auto trees = forest.trees(); trees.next();) {
+			++count;
+		}
+		CHECK(count > 0);
+		CHECK(count < 1000);
+	}
+}
+
+TEST_CASE("Leo's optimization") {
+	// S -> aS | eps makes a chart quadratic in the length of the word without it
+	CFG<Letter> g;
+	g.terminals = {'a', '#'};
+	g.addRule('S', "aS");
+	g.addRule('S', "");
+	g.start = 'S';
+
+	EarleyParser<Letter> p(g);
+	const auto			 as = [](std::size_t n) { return std::vector<Letter>(n, 'a'); };
+	CHECK(p.recognize(as(5000)));
+	CHECK(p.chartSize(as(2000)) < 10 * 2000);
+	CHECK(p.chartSize(as(4000)) <= 2 * p.chartSize(as(2000)) + 10);
+	p.leo = false;
+	CHECK(p.recognize(as(500)));
+	CHECK(p.chartSize(as(2000)) > 2000 * 2000 / 2);
+
+	// right recursion that is not deterministic everywhere, with nullable and ambiguous rules
+	CFG<Letter> h;
+	h.terminals = {'a', 'b', 'c', '#'};
+	h.addRule('S', "aS");
+	h.addRule('S', "aSb");
+	h.addRule('S', "B");
+	h.addRule('S', "");
+	h.addRule('B', "bB");
+	h.addRule('B', "cS");
+	h.addRule('B', "b");
+	h.addRule('C', "Sc");
+	h.addRule('C', "CS");
+	h.start = 'C';
+
+	EarleyParser<Letter> with(h), without(h);
+	without.leo			 = false;
+	std::string alphabet = "abc";
+	srand(53);
+	for (int n = 0; n < 3000; ++n) {
+		std::vector<Letter> w;
+		for (int k = rand() % 14; k > 0; --k) {
+			w.push_back(alphabet[rand() % alphabet.size()]);
+		}
+		CHECK(with.recognize(w) == without.recognize(w));
+		CHECK(with.chartSize(w) <= without.chartSize(w));
+	}
+}
+
+TEST_CASE("online recognizer") {
+	CFG<Letter> g;
+	g.terminals	   = {'i', '(', ')', '.', '+', '#'};
+	g.nonTerminals = {'e', 'E', 't', 'T', 'f'};
+	g.addRule('e', "tE");
+	g.addRule('E', "");
+	g.addRule('E', "+tE");
+	g.addRule('t', "fT");
+	g.addRule('T', "");
+	g.addRule('T', ".fT");
+	g.addRule('f', "(e)");
+	g.addRule('f', "i");
+	g.start = 'e';
+
+	// a token is read exactly when it is expected, and the prefix read so far is accepted when the whole word is
+	EarleyParser<Letter> p(g);
+	std::string			 alphabet = "i().+";
+	srand(59);
+	for (int n = 0; n < 1000; ++n) {
+		auto				r = p.recognizer();
+		std::vector<Letter> w;
+		for (int k = rand() % 16; k > 0; --k) {
+			const Letter l		  = alphabet[rand() % alphabet.size()];
+			const auto	 expected = r.expected();
+			auto		 copy	  = r;
+			CHECK(copy.push(l) == (std::ranges::find(expected, l) != expected.end()));
+			if (r.push(l)) w.push_back(l);
+			CHECK(r.accepted() == p.recognize(w));
+		}
+		CHECK(r.size() == w.size());
+	}
+	auto r = p.recognizer();
+	CHECK(r.push('('));
+	CHECK_FALSE(r.push(')'));
+	CHECK_FALSE(r.push('x'));
+	CHECK(r.push('i'));
+	CHECK_FALSE(r.accepted());
+	CHECK(r.push(')'));
+	CHECK(r.accepted());
+
+	// X derives no word, so S -> aX can not be finished and only b can come after a
+	CFG<Letter> h;
+	h.terminals = {'a', 'b', 'c', '#'};
+	h.addRule('S', "aX");
+	h.addRule('S', "ab");
+	h.addRule('X', "Xc");
+	h.start = 'S';
+
+	EarleyParser<Letter> unproductive(h);
+	auto				 q = unproductive.recognizer();
+	CHECK(q.push('a'));
+	CHECK(q.expected() == std::vector<Letter>{'b'});
+	CHECK_FALSE(q.push('c'));
+	CHECK(q.push('b'));
+	CHECK(q.accepted());
+	CHECK(q.expected().empty());
+
+	// a list of statements only keeps the sets of the statement it is in
+	CFG<Letter> list;
+	list.terminals = {'i', '(', ')', ';', '#'};
+	list.addRule('L', "L;S");
+	list.addRule('L', "S");
+	list.addRule('S', "i");
+	list.addRule('S', "(S)");
+	list.start = 'L';
+
+	EarleyParser<Letter> leftRecursive(list);
+	auto				 statements = leftRecursive.recognizer();
+	for (int k = 0; k < 10000; ++k) {
+		for (const char c : std::string(k % 5 == 0 ? ";((i))" : ";i").substr(k == 0)) {
+			REQUIRE(statements.push(c));
+		}
+		CHECK(statements.liveSets() < 100);
+		CHECK(statements.accepted());
+	}
+	CHECK(statements.push(';'));
+	CHECK_FALSE(statements.accepted());
+	auto next = statements.expected();
+	std::ranges::sort(next);
+	CHECK(next == std::vector<Letter>{'(', 'i'});
+}
+
+TEST_CASE("lookahead") {
+	// e -> e+t | t, t -> t.f | f, f -> (e) | i
+	CFG<Letter> g;
+	g.terminals = {'i', '(', ')', '.', '+', '#'};
+	g.addRule('e', "e+t");
+	g.addRule('e', "t");
+	g.addRule('t', "t.f");
+	g.addRule('t', "f");
+	g.addRule('f', "(e)");
+	g.addRule('f', "i");
+	g.start = 'e';
+	g.eof	= '#';
+
+	// E -> E+E | EE | N | i, N -> eps
+	CFG<Letter> h;
+	h.terminals = {'i', '+', '#'};
+	h.addRule('E', "E+E");
+	h.addRule('E', "EE");
+	h.addRule('E', "N");
+	h.addRule('E', "i");
+	h.addRule('N', "");
+	h.start = 'E';
+
+	for (const auto *grammar : {&g, &h}) {
+		EarleyParser<Letter> all(*grammar), filtered(*grammar);
+		filtered.lookahead = true;
+
+		std::string alphabet = "i().+#";
+		srand(61);
+		for (int n = 0; n < 2000; ++n) {
+			std::vector<Letter> w;
+			for (int k = rand() % 12; k > 0; --k) {
+				w.push_back(alphabet[rand() % alphabet.size()]);
+			}
+			CHECK(filtered.recognize(w) == all.recognize(w));
+			CHECK(filtered.chartSize(w) <= all.chartSize(w));
+			if (w.size() < 8) CHECK(filtered.parseForest(w).size() == all.parseForest(w).size());
+		}
+	}
+
+	// after an operand only the items waiting for the operator that comes next are kept
+	EarleyParser<Letter> all(g), filtered(g);
+	filtered.lookahead = true;
+	std::string expression;
+	for (int k = 0; k < 200; ++k) {
+		expression += k % 3 ? "(i.i)+" : "i.i+";
+	}
+	expression += 'i';
+	const std::vector<Letter> w(expression.begin(), expression.end());
+	CHECK(filtered.recognize(w));
+	// the alternatives share their FIRST sets, so only the items waiting for another operator go
+	CHECK(5 * filtered.chartSize(w) < 4 * all.chartSize(w));
+
+	// Z -> WZ | eps, W -> A | B | ... | T, A -> aY, B -> bY, ..., T -> tY, Y -> x
+	CFG<Letter> disjoint;
+	disjoint.terminals = {'x', '#'};
+	disjoint.addRule('Z', "WZ");
+	disjoint.addRule('Z', "");
+	disjoint.addRule('Y', "x");
+	for (char c = 'a'; c <= 't'; ++c) {
+		const char alternative = char(c - 'a' + 'A');
+		disjoint.terminals.insert(c);
+		disjoint.addRule('W', std::string{alternative});
+		disjoint.addRule(alternative, std::string{c, 'Y'});
+	}
+	disjoint.start = 'Z';
+	disjoint.eof   = '#';
+
+	// every statement predicts all of the alternatives of W, and only one of them can start with the next token
+	EarleyParser<Letter> allDisjoint(disjoint), filteredDisjoint(disjoint);
+	filteredDisjoint.lookahead = true;
+	std::string statements;
+	for (int k = 0; k < 200; ++k) {
+		statements += char('a' + k % 20);
+		statements += 'x';
+	}
+	const std::vector<Letter> v(statements.begin(), statements.end());
+	CHECK(filteredDisjoint.recognize(v));
+	CHECK(4 * filteredDisjoint.chartSize(v) < allDisjoint.chartSize(v));
+}
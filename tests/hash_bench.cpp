@@ -0,0 +1,110 @@
+#include <iostream>
+#include <random>
+#include <ranges>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "datastructures.hpp"
+#include "utils.h"
+
+// compares the node based std containers with the flat ones behind fl::unordered_map and fl::unordered_set on the
+// access patterns of DPDA::delta, SSFT::transitions and the FIRST/FOLLOW sets of CFG
+
+template <class K, class V>
+using StdMap = std::unordered_map<K, V, fl::hash<K>>;
+template <class K>
+using StdSet = std::unordered_set<K, fl::hash<K>>;
+
+using DeltaKey = std::tuple<std::size_t, char, char>;
+using SSFTKey  = std::tuple<std::size_t, char>;
+
+std::size_t sink = 0;
+
+// a parse table: built once, then looked up for every step of a parse, about a third of the lookups miss
+template <class Map>
+void deltaLookups(const std::vector<DeltaKey> &keys, const std::vector<DeltaKey> &queries) {
+	Map delta;
+	for (const auto &[i, key] : std::views::enumerate(keys)) {
+		delta.insert({key, std::tuple<std::size_t, std::size_t>{i, i}});
+	}
+	for (const auto &q : queries) {
+		auto it = delta.find(q);
+		if (it != delta.end()) sink += std::get<0>(it->second);
+	}
+}
+
+// determinization: a find for every transition out of the current state, followed by an insert when it is new
+template <class Map>
+void ssftTransitions(const std::vector<SSFTKey> &keys) {
+	Map transitions;
+	for (const auto &key : keys) {
+		auto it = transitions.find(key);
+		if (it == transitions.end()) transitions.insert({key, {std::get<0>(key), 0}});
+		else ++it->second.second;
+	}
+	sink += transitions.size();
+}
+
+// FIRST/FOLLOW: sets of terminals per non-terminal, merged until nothing changes
+template <class Map>
+void firstSets(std::size_t nonTerminals, std::size_t terminals) {
+	Map first;
+	for (std::size_t n = 0; n < nonTerminals; ++n) {
+		first[n].insert(n % terminals);
+	}
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (std::size_t n = 0; n + 1 < nonTerminals; ++n) {
+			for (const auto &t : first[n + 1]) {
+				changed |= first[n].insert(t).second;
+			}
+		}
+	}
+	for (const auto &[_, set] : first) {
+		sink += set.size();
+	}
+}
+
+int main() {
+	std::mt19937_64							   rng(42);
+	std::uniform_int_distribution<int>		   letter(0, 63);
+	std::uniform_int_distribution<std::size_t> state(0, 4095);
+
+	std::vector<DeltaKey> keys, queries;
+	for (int i = 0; i < 100000; ++i) {
+		keys.push_back({state(rng), char(letter(rng)), char(letter(rng))});
+	}
+	for (int i = 0; i < 1000000; ++i) {
+		if (i % 3) queries.push_back(keys[i % keys.size()]);
+		else queries.push_back({state(rng), char(letter(rng)), char(letter(rng))});
+	}
+
+	std::vector<SSFTKey> ssftKeys;
+	for (int i = 0; i < 1000000; ++i) {
+		ssftKeys.push_back({state(rng) * 4 + i % 4, char(letter(rng))});
+	}
+
+	using Delta = std::tuple<std::size_t, std::size_t>;
+	using Value = std::pair<std::size_t, std::size_t>;
+	BENCH((deltaLookups<StdMap<DeltaKey, Delta>>(keys, queries)), 5, "BENCH delta std::unordered_map: ");
+	BENCH((deltaLookups<fl::unordered_map<DeltaKey, Delta>>(keys, queries)), 5, "BENCH delta fl::unordered_map: ");
+	BENCH((ssftTransitions<StdMap<SSFTKey, Value>>(ssftKeys)), 5, "BENCH SSFT transitions std::unordered_map: ");
+	BENCH((ssftTransitions<fl::unordered_map<SSFTKey, Value>>(ssftKeys)), 5,
+		  "BENCH SSFT transitions fl::unordered_map: ");
+	BENCH((firstSets<StdMap<std::size_t, StdSet<std::size_t>>>(200, 150)), 5, "BENCH FIRST sets std::unordered_set: ");
+	BENCH((firstSets<fl::unordered_map<std::size_t, fl::unordered_set<std::size_t>>>(200, 150)), 5,
+		  "BENCH FIRST sets fl::unordered_set: ");
+
+	// xor combined (i, j) and (j, i) to the same hash
+	StdSet<std::size_t> tupleHashes;
+	for (std::size_t i = 0; i < 256; ++i) {
+		for (std::size_t j = 0; j < 256; ++j) {
+			tupleHashes.insert(fl::hash<std::tuple<std::size_t, std::size_t>>{}({i, j}));
+		}
+	}
+	std::cout << "distinct hashes of 65536 pairs: " << tupleHashes.size() << std::endl;
+	std::cout << "checksum: " << sink << std::endl;
+}
@@ -3,15 +3,21 @@
 #include <cstring>
 #include <exception>
 #include <fstream>
+#include <iterator>
 #include <memory>
+#include <memory_resource>
 #include <ostream>
+#include <sstream>
 #include <string_view>
 
 #include <parser.h>
+#include <incremental_parser.hpp>
+#include <lr_parser.hpp>
 #include <cfg.h>
 #include <utils.h>
 #include <token.h>
 #include <earley.hpp>
+#include <cyk.hpp>
 #include <grammar_factory.hpp>
 
 using namespace fl;
@@ -155,6 +161,69 @@ std::vector<Token> tokenize(std::string &text) {
 	return res;
 }
 
+/**
+ * @brief Reads tokens from a stream one at a time, by the same rules as tokenize, so that a program can be checked
+ * without holding it in memory. Identifiers carry no name. The end of the stream is the end of the input, there is
+ * no eof token.
+ */
+class TokenStream {
+	std::streambuf *in;		// read directly, the istream peek and get are much slower
+	Token			current = Token::eof;
+	bool			done	= false;
+
+	void next() {
+		while (std::isspace(in->sgetc())) {
+			in->sbumpc();
+		}
+		int c = in->sgetc();
+		if (c == std::char_traits<char>::eof()) {
+			done = true;
+		} else if (std::isdigit(c)) {
+			std::size_t num = 0;
+			while (std::isdigit(in->sgetc())) {
+				num = num * 10 + (in->sbumpc() - '0');
+			}
+			current = Token(Number, (uint8_t *)num);
+		} else if (std::isalpha(c)) {
+			std::string name;
+			while (std::isalpha(in->sgetc())) {
+				name += char(in->sbumpc());
+			}
+			if (name == "if") current = If;
+			else if (name == "while") current = While;
+			else if (name == "for") current = For;
+			else current = Identifier;
+		} else {
+			current = char(in->sbumpc());
+		}
+	}
+
+   public:
+	explicit TokenStream(std::istream &in) : in(in.rdbuf()) { next(); }
+
+	class iterator {
+		TokenStream *stream = nullptr;
+
+	   public:
+		using value_type	  = Token;
+		using difference_type = std::ptrdiff_t;
+
+		iterator() = default;
+		explicit iterator(TokenStream *stream) : stream(stream) {}
+
+		const Token &operator*() const { return stream->current; }
+		iterator	&operator++() {
+			   stream->next();
+			   return *this;
+		}
+		void operator++(int) { ++*this; }
+		bool operator==(std::default_sentinel_t) const { return stream->done; }
+	};
+
+	iterator				begin() { return iterator(this); }
+	std::default_sentinel_t end() { return {}; }
+};
+
 struct ASTNode {
 	Token								  type;
 	std::vector<std::unique_ptr<ASTNode>> children;
@@ -203,13 +272,19 @@ int main(int argc, char **argv) {
 			cnt += v.size();
 			random_tokens(v, std::cout);
 		}
+	} else if (argc >= 2 && std::string(argv[1]) == "validate") {
+		Parser<Token> parser(*g, parserCacheFile("language"));
+		bool		  valid = parser.recognize(TokenStream(std::cin));
+		std::cout << (valid ? "valid" : "invalid") << std::endl;
+		return valid ? 0 : 1;
 	} else {
 		try {
 			Parser<Token> parser(*g);
 			// parser.enable_print = true;
 
-			// EarleyParser<Token> earleyParser(*g);
-			// earleyParser.expect_eof = true;
+			EarleyParser<Token> earleyParser(*g);
+			earleyParser.expect_eof = true;
+			earleyParser.lookahead  = true;
 
 			std::stringstream buffer;
 			std::string		  fileName = "test_file.txt";
@@ -230,18 +305,104 @@ int main(int argc, char **argv) {
 			auto tokens = tokenize(text);
 			std::cout << "tokens: " << tokens.size() << std::endl;
 
+			const auto blob = parser.save();
+			BENCH((Parser<Token>(*g)), 10, "BENCH build parser: ");
+			BENCH((Parser<Token>(*g, blob)), 10, "BENCH load parser: ");
+			{
+				Parser<Token> loaded(*g, blob);
+				assert(loaded.save() == blob);
+				assert(loaded.parseFlat(tokens).size() == parser.parseFlat(tokens).size());
+			}
+
+			BENCH(parser.recognize(tokens), 10, "BENCH recognize: ");
+			BENCH(([&] {
+					  std::istringstream in(text);
+					  return parser.recognize(TokenStream(in));
+				  }()),
+				  10, "BENCH recognize a token stream: ");
+			{
+				std::istringstream in(text);
+				assert(parser.recognize(TokenStream(in)) == parser.recognize(tokens));
+			}
+			BENCH(parser.generateProductions(tokens), 10, "BENCH productions: ");
 			BENCH(parser.parse(tokens), 10, "BENCH building parse tree: ");
+			BENCH(parser.parseFlat(tokens), 10, "BENCH building flat parse tree: ");
+			BENCH(([&] {
+					  std::pmr::monotonic_buffer_resource arena;
+					  parser.parseFlat(tokens, &arena);
+				  }()),
+				  10, "BENCH building flat parse tree in an arena: ");
+			BENCH(parser.parseEvents(tokens, ParseEventHandler<Token>{}), 10, "BENCH parse events: ");
+			BENCH(parser.parseEvents(tokens, ParseTreeBuilder<Token>{}), 10, "BENCH flat parse tree from events: ");
+			BENCH(parser.ASTparseEvents(tokens, ParseEventHandler<Token>{}), 10, "BENCH AST events: ");
+			{
+				BENCH((LRParser<Token>(*g)), 10, "BENCH build LALR(1) parser: ");
+				LRParser<Token> lalr(*g);
+				BENCH(lalr.recognize(tokens), 10, "BENCH LALR(1) recognize: ");
+				BENCH(lalr.parse(tokens), 10, "BENCH LALR(1) parse tree: ");
+				assert(lalr.recognize(tokens) == parser.recognize(tokens));
+			}
+			{
+				// edit a number in the middle of the program
+				std::size_t middle = tokens.size() / 2;
+				while (middle < tokens.size() && tokens[middle] != Number) {
+					++middle;
+				}
+				if (middle < tokens.size()) {
+					std::vector<Token> edited = tokens;
+					edited[middle]			  = Token(Number, (uint8_t *)42);
+					BENCH(IncrementalParser<Token>(parser, tokens), 10, "BENCH incremental parse: ");
+					IncrementalParser<Token> incremental(parser, tokens);
+					BENCH(incremental.edit(middle, 1, std::vector{edited[middle]}), 10,
+						  "BENCH incremental reparse of a number: ");
+					std::size_t scope = middle;
+					while (scope < tokens.size() && tokens[scope] != '{') {
+						++scope;
+					}
+					if (scope < tokens.size()) {
+						BENCH((incremental.edit(scope + 1, 0, std::vector<Token>{Identifier, ';'}),
+							   incremental.edit(scope + 1, 2, std::vector<Token>{})),
+							  10, "BENCH incremental insert and remove a statement: ");
+					}
+					if (tokens.size() < 1000) {
+						std::stringstream expected, actual;
+						expected << parser.parseFlat(edited);
+						actual << incremental.tree();
+						assert(expected.str() == actual.str());
+					}
+				}
+			}
 			auto t = parser.parse(tokens);
 			if (tokens.size() < 1000) std::cout << t << std::endl;
 
-			// BENCH(earleyParser.recognize(tokens), 10, "BENCH earley parse: ");
-			// assert(earleyParser.recognize(tokens));
+			if (tokens.size() <= 20000) {
+				BENCH(earleyParser.recognize(tokens), 10, "BENCH earley parse: ");
+				assert(earleyParser.recognize(tokens));
+				BENCH((earleyParser.parseForest(tokens)), 10, "BENCH earley parse forest: ");
+				assert(earleyParser.parseForest(tokens).extract() != nullptr);
+			}
+			if (tokens.size() <= 500) {
+				std::unique_ptr<CYKParser<Token>> cyk;
+				BENCH((cyk = std::make_unique<CYKParser<Token>>(*g)), 1, "BENCH build CYK recognizer: ");
+				cyk->expect_eof = true;
+				BENCH(cyk->recognize(tokens), 10, "BENCH CYK recognize: ");
+				assert(cyk->recognize(tokens));
+			}
 			//  std::cout << t << std::endl;
 
 			// BENCH(parser.ASTparse(tokens), 100, "BENCH building AST: ");
 			if (tokens.size() < 1000) {
 				auto ast = parser.ASTparse(tokens);
 				std::cout << (ASTNode *)ast.get() << std::endl;
+
+				std::stringstream flat, tree;
+				flat << (ASTNode *)parser.ASTparseFlat(tokens).toParseNode().get();
+				tree << (ASTNode *)ast.get();
+				assert(flat.str() == tree.str());
+
+				std::stringstream bottomUp;
+				bottomUp << (ASTNode *)LRParser<Token>(*g).ASTparse(tokens).get();
+				assert(bottomUp.str() == tree.str());
 			}
 
 		} catch (const std::exception &e) { std::cerr << e << std::endl; }
@@ -6,8 +6,7 @@
 #include <TFSA.hpp>
 #include <letter.hpp>
 #include "SSFT.hpp"
-#include "ambiguity.hpp"
-#include "functionality.hpp"
+#include "analysis.hpp"
 
 using namespace fl;
 
@@ -101,13 +100,19 @@ int main(int argc, char **argv) {
 		if (tokens.size() < 1000) drawFSA(fsa);
 		std::cout << "Trimmed FSA has " << fsa.N << " states and " << fsa.transitions.size() << " transitions and "
 				  << fsa.words.size() << " words." << std::endl;
-		bool isFunc = isFunctional(fsa);
-		std::cout << "isFunctional: " << isFunc << std::endl;
+		AnalysisReport report;
+		BENCH(report = analyze(fsa), 1, "BENCH analyze: ");
+		std::cout << "isFunctional: " << report.functional << std::endl;
+		std::cout << "bounded variation: " << report.boundedVariation << std::endl;
 
-		if (!isFunc) {
+		if (!report.functional) {
 			std::cout << "The FSA is not functional!" << std::endl;
 			return 1;
 		}
+		if (!report.boundedVariation) {
+			std::cout << "The FSA cannot be made subsequential!" << std::endl;
+			return 1;
+		}
 		try {
 			std::cout << "converting to SSFT..." << std::endl;
 			auto ssfst = SSFT<Letter>(std::move(fsa));